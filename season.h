@@ -26,6 +26,8 @@ DOCUMENTATION
         * enum season_type
             - JSON element type, used for element creation
             - YOU NEED TO SET IT YOURSELF IF YOU CREATE A SEASON ELEMENT AT HAND
+            - Such an element must also be zero-initialized (struct season s = {0};
+              or the helper macros), the library reads its other '_' fields.
 
         * struct season
             - JSON element, includes all types using union,
@@ -47,6 +49,13 @@ DOCUMENTATION
         * struct season season_string(const char *s);
             - Create season from char*
 
+        * struct season season_string_n(const char *s, size_t len);
+            - Create season from the len first bytes of s, which may contain '\0'.
+
+        * struct season season_string_take(char *s, size_t len);
+            - Create season from s without copying it, the season takes ownership.
+            - s must be malloc'd, len bytes long and followed by a '\0'.
+
         * struct season *season_object_get(struct season *object, const char *key);
             - Retrieve value from object by key.
             - Returns NULL if key is not found.
@@ -54,6 +63,20 @@ DOCUMENTATION
         * void season_object_add(struct season *object, char *key, struct season item);
             - Add key-value pair to object.
             - Overwrites key if already present.
+            - item is moved into object, it shall not be freed by the caller.
+
+        * struct season *season_object_get_n(struct season *object, const char *key, size_t len);
+        * void season_object_add_n(struct season *object, const char *key, size_t len, struct season item);
+            - Same as above, with a key of len bytes that needs no '\0'.
+            - Keys can't contain '\0': season_object_add_n keeps the key up to
+              its first '\0', season_object_get_n finds no key containing one.
+
+        * void season_object_add_take(struct season *object, char *key, struct season item);
+            - Same as season_object_add, but object takes ownership of key.
+            - key must be malloc'd, it is freed if the key was already present.
+
+        * void season_object_reserve(struct season *object, size_t capacity);
+            - Make room for at least capacity key-value pairs.
 
         * void season_object_remove(struct season *object, char *key);
             - Remove key-value pair from object by key.
@@ -62,6 +85,8 @@ DOCUMENTATION
         * struct season *season_array_get(struct season *array, size_t idx);
             - Retrieve item from array at idx.
             - Returns NULL if out of range.
+            - Converts a packed array to generic storage, use the typed
+              accessors below to read packed arrays.
 
         * void season_array_add(struct season *array, struct season item);
             - Append item to array.
@@ -75,14 +100,131 @@ DOCUMENTATION
             - Shifts items right. (just to clarify)
             - Appends if idx is out-of-range.
 
+        * void season_array_reserve(struct season *array, size_t capacity);
+            - Make room for at least capacity items.
+
         * void season_load(struct season *season, char *json_string);
             - Parse json_string into season.
+            - \uXXXX escapes (including surrogate pairs) are decoded to UTF-8.
+            - Strings must be valid UTF-8, the scan is vectorized when
+              compiled with SSE2 (ASCII) or SSSE3 (full validation).
+
+        * void season_reload(struct season *season, char *json, size_t len,
+                             size_t edit_start, size_t old_len, size_t new_len);
+            - Only with SEASON_SPANS defined before including this file, which
+              makes season_load remember where every value comes from.
+            - season was loaded from a text in which the old_len bytes at
+              edit_start were replaced by new_len bytes, giving json (len
+              bytes, '\0' terminated). Update season to match json.
+            - Only the smallest value enclosing the edit is parsed again and
+              spliced in place, its parents and siblings are kept. Edits
+              between members, on the first byte of a value or inside a
+              packed array parse the parent again.
+            - season must come from season_load or season_reload and not have
+              been modified since.
+            - Parse errors found while parsing only part of json give the byte
+              offset of the token instead of its line and column.
 
         * void season_render(struct season *season, FILE *stream);
             - Write JSON representation of season to stream.
 
+        * void season_render_ex(struct season *season, FILE *stream, int flags);
+            - Same as season_render, flags is a combination of:
+                SEASON_RENDER_ASCII     - escape all non-ASCII characters as \uXXXX
+                SEASON_RENDER_COMPACT   - use "," and ":" separators, without spaces
+                SEASON_RENDER_CANONICAL - sort object keys bytewise and write numbers
+                                          in their shortest round-trip form, so
+                                          equal documents render identically
+
+        * void season_render_begin(struct season_render_cursor *cur, struct season *season, int flags);
+            - Start rendering season piece by piece, flags as in season_render_ex.
+            - season must not be modified until rendering is over.
+
+        * size_t season_render_next(struct season_render_cursor *cur, char *buf, size_t cap);
+            - Write the next at most cap bytes of the rendering into buf.
+            - Returns the number of bytes written, 0 once everything was.
+            - Can be called whenever, memory used only grows with nesting depth.
+
+        * void season_render_end(struct season_render_cursor *cur);
+            - Release cur, needed only when stopping before the end.
+
+        * void season_reformat(FILE *in, FILE *out, int indent);
+            - Stream JSON text from in to out, without building a tree.
+            - indent = 0 minifies, indent > 0 pretty-prints with that many
+              spaces per level.
+            - Uses constant memory. Input is tokenized but not validated,
+              strings and numbers are copied as is.
+            - Several top-level values are written one per line.
+
+        * uint64_t season_hash(struct season *season);
+            - Hash of the content of season, equal values hash equally.
+            - Object members are hashed independently of their order.
+            - Define SEASON_HASH_MEMO before including this file to memoize
+              the hash in every node. Nodes modified through the API forget
+              their hash, but their parents don't: after modifying a nested
+              value, call season_hash_reset on the root.
+
+        * void season_hash_reset(struct season *season);
+            - Recursively forget memoized hashes (no-op without SEASON_HASH_MEMO).
+
+        * int season_equal(struct season *a, struct season *b);
+            - Deep equality, object members are compared regardless of order.
+            - With SEASON_HASH_MEMO, different hashes reject without a walk.
+
         * void season_free(struct season *season);
             - Recursively free all memory associated with season structure.
+            - Does nothing on values loaded by a season_parser.
+
+    Packed arrays
+        Arrays containing only numbers are stored by the parser as a contiguous
+        buffer of int64_t (integers only) or double. Inserting anything but a
+        number converts them back to generic storage, transparently.
+
+        * double season_array_number(struct season *array, size_t idx);
+        * int64_t season_array_int(struct season *array, size_t idx);
+            - Retrieve number from array at idx, packed or not.
+            - idx must be in range and the item must be a number.
+
+        * double *season_array_doubles(struct season *array);
+        * int64_t *season_array_ints(struct season *array);
+            - Direct access to the packed buffer of array.
+            - Returns NULL if array is not packed with this type.
+
+        * void season_array_add_numbers(struct season *array, const double *values, size_t n);
+        * void season_array_add_ints(struct season *array, const int64_t *values, size_t n);
+            - Append n numbers to array.
+            - An empty array becomes packed.
+
+        * double season_array_sum(struct season *array);
+        * double season_array_min(struct season *array);
+        * double season_array_max(struct season *array);
+            - Reduce a numbers-only array, vectorized for packed arrays with
+              SSE2 (min and max of integer arrays need SSE4.2).
+            - min and max return NAN for an empty array.
+
+    Parser context
+        For high rates of small documents, a season_parser keeps its scratch
+        stacks, an arena sized after previous documents and a table of
+        interned object keys from one document to the next, so once warmed
+        up, loading a document doesn't call the allocator.
+
+        * void season_parser_init(struct season_parser *parser);
+            - Initialize an empty parser.
+
+        * void season_parser_load(struct season_parser *parser, struct season *season,
+                                  const char *json, size_t len);
+            - Parse len bytes of json into season, json needs no terminator.
+            - season belongs to the parser: it is read-only (modifying it
+              asserts), season_free does nothing on it, and it stays valid
+              until season_parser_reset or season_parser_free.
+            - Arrays are never packed.
+
+        * void season_parser_reset(struct season_parser *parser);
+            - Release every document loaded by parser, keeping its memory
+              for the next ones.
+
+        * void season_parser_free(struct season_parser *parser);
+            - Free all memory associated with parser.
 
     Short mode
         Do this:
@@ -124,10 +266,15 @@ LICENSE
 #define SEASON_H
 
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 enum season_type {
     SEASON_STRING = 0,
     SEASON_NULL = 1,
@@ -159,11 +306,30 @@ struct _season_object {
 struct _season_array {
     size_t count;
     size_t capacity;
-    struct season *items;
+    union {
+        struct season *items;
+        double *f64;  // _SEASON_PACKED_F64
+        int64_t *i64; // _SEASON_PACKED_I64
+    };
+};
+
+enum _season_packing {
+    _SEASON_PACKED_NONE = 0,
+    _SEASON_PACKED_F64,
+    _SEASON_PACKED_I64,
 };
 
 struct season {
     enum season_type type;
+    unsigned char _packed; // enum _season_packing, arrays only
+    unsigned char _arena;  // memory owned by a season_parser
+#ifdef SEASON_HASH_MEMO
+    uint64_t _hash; // memoized season_hash, 0 if not computed
+#endif
+#ifdef SEASON_SPANS
+    size_t _span_start; // source offset, relative to the parent's
+    size_t _span_len;   // source length, 0 if unknown
+#endif
     union {
         double number;
         int boolean;
@@ -174,6 +340,8 @@ struct season {
 };
 
 struct season season_string(const char *s);
+struct season season_string_n(const char *s, size_t len);
+struct season season_string_take(char *s, size_t len);
 
 #define season_object() ((struct season){.type=SEASON_OBJECT})
 #define season_array() ((struct season){.type=SEASON_ARRAY})
@@ -182,18 +350,97 @@ struct season season_string(const char *s);
 #define season_null() ((struct season){.type=SEASON_NULL})
 
 struct season *season_object_get(struct season *object, const char *key);
+struct season *season_object_get_n(struct season *object, const char *key, size_t len);
 void season_object_add(struct season *object, char *key, struct season item);
+void season_object_add_n(struct season *object, const char *key, size_t len, struct season item);
+void season_object_add_take(struct season *object, char *key, struct season item);
 void season_object_remove(struct season *object, char *key);
+void season_object_reserve(struct season *object, size_t capacity);
 
 struct season *season_array_get(struct season *array, size_t idx);
 void season_array_add(struct season *array, struct season item);
 void season_array_remove(struct season *array, size_t idx);
 void season_array_insert(struct season *array, struct season item, size_t idx);
+void season_array_reserve(struct season *array, size_t capacity);
+
+double season_array_number(struct season *array, size_t idx);
+int64_t season_array_int(struct season *array, size_t idx);
+double *season_array_doubles(struct season *array);
+int64_t *season_array_ints(struct season *array);
+void season_array_add_numbers(struct season *array, const double *values, size_t n);
+void season_array_add_ints(struct season *array, const int64_t *values, size_t n);
+double season_array_sum(struct season *array);
+double season_array_min(struct season *array);
+double season_array_max(struct season *array);
+
+// Longest rendering of a number, "%lf" of -DBL_MAX is 317 characters
+#define _SEASON_NUMBER_MAX 320
+
+enum season_render_flags {
+    SEASON_RENDER_ASCII = 1 << 0,
+    SEASON_RENDER_COMPACT = 1 << 1,
+    SEASON_RENDER_CANONICAL = 1 << 2,
+};
 
 void season_load(struct season *season, char *json_string);
+#ifdef SEASON_SPANS
+void season_reload(struct season *season, char *json, size_t len,
+                   size_t edit_start, size_t old_len, size_t new_len);
+#endif
 void season_render(struct season *season, FILE *stream);
+void season_render_ex(struct season *season, FILE *stream, int flags);
+void season_reformat(FILE *in, FILE *out, int indent);
+
+struct _season_render_frame;
+
+struct season_render_cursor {
+    int flags;
+    struct season *next; // value to start
+    struct _season_render_frame *stack;
+    size_t depth;
+    size_t capacity;
+    const char *str; // string being written
+    size_t str_len;
+    int in_str;
+    char pending[2 + _SEASON_NUMBER_MAX]; // piece not written yet, separator included
+    size_t pending_len;
+    size_t pending_off;
+};
+
+void season_render_begin(struct season_render_cursor *cur, struct season *season, int flags);
+size_t season_render_next(struct season_render_cursor *cur, char *buf, size_t cap);
+void season_render_end(struct season_render_cursor *cur);
+uint64_t season_hash(struct season *season);
+void season_hash_reset(struct season *season);
+int season_equal(struct season *a, struct season *b);
 void season_free(struct season *season);
 
+struct _season_arena_block;
+struct _season_parser_member;
+struct _season_interned;
+
+struct season_parser {
+    struct _season_arena_block *arena;
+    size_t arena_hint; // bytes used by previous documents
+
+    struct season *values; // scratch stack of array items
+    size_t values_count;
+    size_t values_capacity;
+    struct _season_parser_member *members; // scratch stack of object members
+    size_t members_count;
+    size_t members_capacity;
+
+    struct _season_interned *interned; // open addressing, power of 2 capacity
+    size_t interned_count;
+    size_t interned_capacity;
+};
+
+void season_parser_init(struct season_parser *parser);
+void season_parser_load(struct season_parser *parser, struct season *season,
+                        const char *json, size_t len);
+void season_parser_reset(struct season_parser *parser);
+void season_parser_free(struct season_parser *parser);
+
 #ifdef SEASON_SHORT
 typedef struct season season;
 #define season_obj_get season_object_get
@@ -212,10 +459,26 @@ typedef struct season season;
 #define season_bool season_boolean
 #endif
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
 #ifdef SEASON_IMPLEMENTATION
 #undef SEASON_IMPLEMENTATION
 
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
 #define _SEASON_LEX_UNREACH(...) \
         do { \
             printf("%s:%d: UNREACHABLE: %s \n", __FILE__, __LINE__, __VA_ARGS__); \
@@ -232,6 +495,22 @@ typedef struct season season;
             } \
         }while(0)
 
+#define _SEASON_ASSERT_OWNED(s) \
+        SEASON_ASSERT(!(s)->_arena, "value is owned by a season_parser")
+
+#ifdef SEASON_HASH_MEMO
+#define _SEASON_HASH_FORGET(s) ((s)->_hash = 0)
+#else
+#define _SEASON_HASH_FORGET(s) ((void)(s))
+#endif
+
+#ifdef SEASON_SPANS
+#define _SEASON_SPAN(v, start, end, base) \
+        ((v)._span_start = (start) - (base), (v)._span_len = (end) - (start))
+#else
+#define _SEASON_SPAN(v, start, end, base) ((void)(start), (void)(end), (void)(base))
+#endif
+
 #define SEASON_ERROR(fmt, ...) \
         do { \
             fprintf(stderr, "error: %s:%d: %s: " fmt "\n", \
@@ -241,8 +520,12 @@ typedef struct season season;
 
 #define SEASON_PARSE_ERROR(fmt, ...) \
         do { \
-            fprintf(stderr, "season parse error: line %ld column %ld: " fmt "\n",\
-                    t.line, t.column, ##__VA_ARGS__); \
+            if (t.line) \
+                fprintf(stderr, "season parse error: line %ld column %ld: " fmt "\n",\
+                        t.line, t.column, ##__VA_ARGS__); \
+            else \
+                fprintf(stderr, "season parse error: offset %ld: " fmt "\n",\
+                        t.column, ##__VA_ARGS__); \
             exit(1); \
         }while(0)
 
@@ -277,6 +560,7 @@ struct _season_lexer {
     size_t cursor;
     size_t line;
     size_t bol;
+    int offsets; // lines unknown, tokens report their offset as column
 };
 
 static const enum _season_token_type SEASON_LITERAL_MAP[256] = {
@@ -289,12 +573,14 @@ static const enum _season_token_type SEASON_LITERAL_MAP[256] = {
 };
 
 struct _season_lexer _season_lex_init(char *content, size_t content_len){
-    struct _season_lexer l = {content, content_len, 0, 0, 0};
+    struct _season_lexer l = {content, content_len, 0, 0, 0, 0};
     return l;
 }
 
-#define _season_is_num_start(c) (strchr("0123456789-", c) != NULL)
-#define _season_is_num(c) (strchr("0123456789-.eE", c) != NULL)
+#define _season_is_digit(c) ((c) >= '0' && (c) <= '9')
+#define _season_is_num_start(c) (_season_is_digit(c) || (c) == '-')
+#define _season_is_num(c) (_season_is_digit(c) || (c) == '-' || (c) == '.' \
+                           || (c) == 'e' || (c) == 'E' || (c) == '+')
 
 char _season_lex_chop_char(struct _season_lexer *l){
     char x = l->content[l->cursor];
@@ -306,6 +592,163 @@ char _season_lex_chop_char(struct _season_lexer *l){
     return x;
 }
 
+// Length of the valid UTF-8 sequence starting at s, 0 if invalid
+size_t _season_utf8_step(const unsigned char *s, size_t len) {
+    unsigned char c = s[0];
+    if (c < 0x80) return 1;
+    if (c < 0xC2 || c > 0xF4) return 0;
+    if (c < 0xE0) {
+        if (len < 2 || (s[1] & 0xC0) != 0x80) return 0;
+        return 2;
+    }
+    if (c < 0xF0) {
+        if (len < 3 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) return 0;
+        if (c == 0xE0 && s[1] < 0xA0) return 0; // overlong
+        if (c == 0xED && s[1] > 0x9F) return 0; // surrogate
+        return 3;
+    }
+    if (len < 4 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80
+            || (s[3] & 0xC0) != 0x80) return 0;
+    if (c == 0xF0 && s[1] < 0x90) return 0; // overlong
+    if (c == 0xF4 && s[1] > 0x8F) return 0; // > U+10FFFF
+    return 4;
+}
+
+#if defined(__SSSE3__)
+// Lookup tables of the Keiser-Lemire validator, indexed by nibbles of
+// the previous byte (high and low) and of the current byte (high)
+static const unsigned char _SEASON_UTF8_PREV_HIGH[16] = {
+    0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02,
+    0x80, 0x80, 0x80, 0x80, 0x21, 0x01, 0x15, 0x49
+};
+static const unsigned char _SEASON_UTF8_PREV_LOW[16] = {
+    0xE7, 0xA3, 0x83, 0x83, 0x8B, 0xCB, 0xCB, 0xCB,
+    0xCB, 0xCB, 0xCB, 0xCB, 0xCB, 0xDB, 0xCB, 0xCB
+};
+static const unsigned char _SEASON_UTF8_CUR_HIGH[16] = {
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0xE6, 0xAE, 0xBA, 0xBA, 0x01, 0x01, 0x01, 0x01
+};
+static const unsigned char _SEASON_UTF8_INCOMPLETE[16] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF
+};
+#endif
+
+int _season_utf8_valid(const char *str, size_t len) {
+    const unsigned char *s = (const unsigned char *)str;
+    size_t i = 0;
+#if defined(__SSSE3__)
+    const __m128i prev_high = _mm_loadu_si128((const __m128i *)_SEASON_UTF8_PREV_HIGH);
+    const __m128i prev_low = _mm_loadu_si128((const __m128i *)_SEASON_UTF8_PREV_LOW);
+    const __m128i cur_high = _mm_loadu_si128((const __m128i *)_SEASON_UTF8_CUR_HIGH);
+    const __m128i incomplete = _mm_loadu_si128((const __m128i *)_SEASON_UTF8_INCOMPLETE);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    unsigned char tail[16];
+
+    while (i < len) {
+        __m128i in;
+        if (i + 16 <= len) {
+            in = _mm_loadu_si128((const __m128i *)(s + i));
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, len - i);
+            in = _mm_loadu_si128((const __m128i *)tail);
+        }
+        i += 16;
+
+        if (!_mm_movemask_epi8(in)) {
+            error = _mm_or_si128(error, prev_incomplete);
+            prev_incomplete = _mm_setzero_si128();
+            prev = in;
+            continue;
+        }
+
+        __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+        __m128i special = _mm_and_si128(_mm_and_si128(
+            _mm_shuffle_epi8(prev_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+            _mm_shuffle_epi8(prev_low, _mm_and_si128(prev1, nibble))),
+            _mm_shuffle_epi8(cur_high, _mm_and_si128(_mm_srli_epi16(in, 4), nibble)));
+
+        // Third and fourth bytes of a sequence must be continuations
+        __m128i third = _mm_subs_epu8(_mm_alignr_epi8(in, prev, 14), _mm_set1_epi8(0xE0-0x80));
+        __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(in, prev, 13), _mm_set1_epi8((char)(0xF0-0x80)));
+        __m128i must_cont = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+        error = _mm_or_si128(error, _mm_xor_si128(must_cont, special));
+
+        prev_incomplete = _mm_subs_epu8(in, incomplete);
+        prev = in;
+    }
+    error = _mm_or_si128(error, prev_incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+#else
+#if defined(__SSE2__)
+    while (i + 16 <= len) {
+        if (!_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + i)))) {
+            i += 16;
+            continue;
+        }
+        // Validate sequence by sequence until we are past this block
+        size_t stop = i + 16;
+        while (i < stop) {
+            size_t n = _season_utf8_step(s + i, len - i);
+            if (!n) return 0;
+            i += n;
+        }
+    }
+#endif
+    while (i < len) {
+        size_t n = _season_utf8_step(s + i, len - i);
+        if (!n) return 0;
+        i += n;
+    }
+    return 1;
+#endif
+}
+
+// Advance l->cursor to the closing quote of a string, skipping escaped
+// characters. If unterminated, l->cursor ends up at content_len, or one
+// past it when the content ends with a backslash.
+// Returns non-zero if the string contains bytes outside of ASCII.
+int _season_lex_string(struct _season_lexer *l) {
+    const char *s = l->content;
+    size_t i = l->cursor, n = l->content_len;
+    int high = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+#endif
+    while (i < n) {
+#if defined(__SSE2__)
+        if (i + 16 <= n) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+            int stop = _mm_movemask_epi8(_mm_or_si128(
+                _mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)));
+            if (!stop) {
+                high |= _mm_movemask_epi8(v);
+                i += 16;
+                continue;
+            }
+            high |= _mm_movemask_epi8(v) & ((stop & -stop) - 1);
+            i += __builtin_ctz(stop);
+        }
+#endif
+        char c = s[i];
+        if (c == '"') break;
+        if (c == '\\') {
+            i += 2;
+            continue;
+        }
+        high |= c & 0x80;
+        i++;
+    }
+    l->cursor = i;
+    return high;
+}
+
 struct _season_token _season_lex_next(struct _season_lexer *l){
     while (l->cursor < l->content_len && isspace(l->content[l->cursor])){
         (void)_season_lex_chop_char(l);
@@ -313,8 +756,8 @@ struct _season_token _season_lex_next(struct _season_lexer *l){
 
     struct _season_token token = {
         .type = _SEASON_TOK_END,
-        .line = l->line+1,
-        .column = l->cursor-l->bol+1,
+        .line = l->offsets ? 0 : l->line+1,
+        .column = l->offsets ? l->cursor : l->cursor-l->bol+1,
         .text = &l->content[l->cursor]
     };
 
@@ -324,11 +767,19 @@ struct _season_token _season_lex_next(struct _season_lexer *l){
         token.type = _SEASON_TOK_STRING;
         l->cursor++;
         token.text++;
-        while (l->cursor < l->content_len && l->content[l->cursor] != '"') {
-            token.text_len++;
-            l->cursor++;
+        int high = _season_lex_string(l);
+        if (l->cursor >= l->content_len) {
+            l->cursor = l->content_len;
+            token.type = _SEASON_TOK_INVALID;
+            token.text_len = &l->content[l->cursor] - token.text;
+            return token;
         }
+        token.text_len = &l->content[l->cursor] - token.text;
         l->cursor++;
+        if (high && !_season_utf8_valid(token.text, token.text_len)) {
+            struct _season_token t = token;
+            SEASON_PARSE_ERROR("Invalid UTF-8 in string");
+        }
         return token;
     }
 
@@ -343,15 +794,18 @@ struct _season_token _season_lex_next(struct _season_lexer *l){
 
     if (islower(l->content[l->cursor])) {
         token.type = _SEASON_TOK_INVALID;
-        if (strncmp(&l->content[l->cursor], "null", 4) == 0) {
+        if (l->content_len - l->cursor >= 4
+                && memcmp(&l->content[l->cursor], "null", 4) == 0) {
             token.type = _SEASON_TOK_NULL;
             token.text_len = 4;
             l->cursor += 4;
-        } else if (strncmp(&l->content[l->cursor], "true", 4) == 0) {
+        } else if (l->content_len - l->cursor >= 4
+                && memcmp(&l->content[l->cursor], "true", 4) == 0) {
             token.type = _SEASON_TOK_TRUE;
             token.text_len = 4;
             l->cursor += 4;
-        } else if (strncmp(&l->content[l->cursor], "false", 5) == 0) {
+        } else if (l->content_len - l->cursor >= 5
+                && memcmp(&l->content[l->cursor], "false", 5) == 0) {
             token.type = _SEASON_TOK_FALSE;
             token.text_len = 5;
             l->cursor += 5;
@@ -374,13 +828,6 @@ struct _season_token _season_lex_next(struct _season_lexer *l){
 }
 
 
-char *_season_strdup(const char *s) { // C99 don't have strdup
-    size_t size = strlen(s) + 1;
-    char *str = malloc(size);
-    if (str) memcpy(str, s, size);
-    return str;
-}
-
 int _season_is_int(double x) {
     const double eps = 1e-9;
     long xi = (long)x;
@@ -391,74 +838,215 @@ int _season_is_int(double x) {
 }
 
 
-char *_season_escape(const char *str, size_t len) {
-    char *out = malloc(len*2 + 1);
-    if (!out) return NULL;
+// Decode the code point of the valid UTF-8 sequence of length n at s
+unsigned long _season_utf8_decode(const unsigned char *s, size_t n) {
+    switch (n) {
+        case 1: return s[0];
+        case 2: return ((s[0] & 0x1FUL) << 6) | (s[1] & 0x3F);
+        case 3: return ((s[0] & 0x0FUL) << 12) | ((s[1] & 0x3FUL) << 6) | (s[2] & 0x3F);
+        default: return ((s[0] & 0x07UL) << 18) | ((s[1] & 0x3FUL) << 12)
+                        | ((s[2] & 0x3FUL) << 6) | (s[3] & 0x3F);
+    }
+}
 
-    char *p = out;
+// Encode cp as UTF-8 into p, returns the number of bytes written
+size_t _season_utf8_encode(char *p, unsigned long cp) {
+    if (cp < 0x80) {
+        p[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        p[0] = (char)(0xC0 | (cp >> 6));
+        p[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        p[0] = (char)(0xE0 | (cp >> 12));
+        p[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        p[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    p[0] = (char)(0xF0 | (cp >> 18));
+    p[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    p[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    p[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
 
-    while (len--) {
-        char c = *str++;
-        switch (c) {
-            case '"':  *p++ = '\\'; *p++ = '"';  break;
-            case '\\': *p++ = '\\'; *p++ = '\\'; break;
-            case '/':  *p++ = '\\'; *p++ = '/';  break;
-            case '\b': *p++ = '\\'; *p++ = 'b';  break;
-            case '\t': *p++ = '\\'; *p++ = 't';  break;
-            case '\n': *p++ = '\\'; *p++ = 'n';  break;
-            case '\v': *p++ = '\\'; *p++ = 'v';  break;
-            case '\f': *p++ = '\\'; *p++ = 'f';  break;
-            case '\r': *p++ = '\\'; *p++ = 'r';  break;
-            default:
-                *p++ = c;
-                break;
+// Index of the first byte of str that can't be written as is: '"', '\\',
+// control characters and, with SEASON_RENDER_ASCII, non-ASCII bytes
+size_t _season_escape_scan(const char *str, size_t len, int flags) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    const __m128i space = _mm_set1_epi8(0x20);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(str + i));
+        __m128i special = _mm_or_si128(
+            _mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+        if (flags & SEASON_RENDER_ASCII) {
+            // Signed compare, bytes >= 0x80 are negative
+            special = _mm_or_si128(special, _mm_cmplt_epi8(v, space));
+        } else {
+            special = _mm_or_si128(special,
+                _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
         }
+        int mask = _mm_movemask_epi8(special);
+        if (mask) return i + __builtin_ctz(mask);
     }
-    *p = '\0';
-    return out;
+#endif
+    for (; i < len; i++) {
+        unsigned char c = str[i];
+        if (c == '"' || c == '\\' || c < 0x20) break;
+        if ((flags & SEASON_RENDER_ASCII) && c >= 0x80) break;
+    }
+    return i;
 }
 
-char *_season_unescape(const char *str, size_t len) {
-    char *out = malloc(len + 1);
-    char *p = out;
+// Write the escape sequence of the character at str into esc (at least
+// 32 bytes), returns its length and sets *n to the bytes consumed
+size_t _season_escape_char(char *esc, const char *str, size_t len, size_t *n) {
+    unsigned char c = *str;
+    *n = 1;
+    esc[0] = '\\';
+    switch (c) {
+        case '"':  esc[1] = '"';  return 2;
+        case '\\': esc[1] = '\\'; return 2;
+        case '\b': esc[1] = 'b';  return 2;
+        case '\t': esc[1] = 't';  return 2;
+        case '\n': esc[1] = 'n';  return 2;
+        case '\f': esc[1] = 'f';  return 2;
+        case '\r': esc[1] = 'r';  return 2;
+    }
+    if (c < 0x20) return sprintf(esc, "\\u%04x", c);
+
+    // Non-ASCII in SEASON_RENDER_ASCII mode
+    unsigned long cp = 0xFFFD;
+    size_t k = _season_utf8_step((const unsigned char *)str, len);
+    if (k) {
+        cp = _season_utf8_decode((const unsigned char *)str, k);
+        *n = k;
+    }
+    if (cp >= 0x10000) {
+        cp -= 0x10000;
+        return sprintf(esc, "\\u%04lx\\u%04lx", 0xD800 + (cp >> 10), 0xDC00 + (cp & 0x3FF));
+    }
+    return sprintf(esc, "\\u%04lx", cp);
+}
 
-    while(len--) {
-        if (*str == '\\') {
-            str++;
-            char next = *str;
-            switch(next) {
-                case '"':
-                case '\\':
-                case '/':
-                    *p++ = next;
-                    break;
-                case 'b':*p++ = 8;break;
-                case 't':*p++ = 9;break;
-                case 'n':*p++ = 10;break;
-                case 'v':*p++ = 11;break;
-                case 'f':*p++ = 12;break;
-                case 'r':*p++ = 13;break;
-                case 'u':
-                    SEASON_ERROR("Unicode is not yet supported");
-                default:
-                    SEASON_ERROR("Invalid escape code");
+// Write str as a quoted JSON string, clean runs are written as is
+void _season_render_string(FILE *stream, const char *str, size_t len, int flags) {
+    char esc[32];
+    fputc('"', stream);
+    while (len) {
+        size_t run = _season_escape_scan(str, len, flags);
+        if (run) fwrite(str, 1, run, stream);
+        str += run;
+        len -= run;
+        if (!len) break;
+
+        size_t n;
+        fwrite(esc, 1, _season_escape_char(esc, str, len, &n), stream);
+        str += n;
+        len -= n;
+    }
+    fputc('"', stream);
+}
+
+long _season_hex4(const char *str, const char *end) {
+    if (end - str < 4) return -1;
+    long cp = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = str[i];
+        cp <<= 4;
+        if (c >= '0' && c <= '9') cp |= c - '0';
+        else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+        else return -1;
+    }
+    return cp;
+}
+
+// Unescape the string token t into out (at least t.text_len + 1 bytes),
+// returns the unescaped length
+size_t _season_unescape_into(char *out, struct _season_token t) {
+    char *p = out;
+    const char *str = t.text;
+    const char *end = str + t.text_len;
+
+    while (str < end) {
+        const char *bs = memchr(str, '\\', end - str);
+        if (bs == NULL) bs = end;
+        memcpy(p, str, bs - str);
+        p += bs - str;
+        str = bs;
+        if (str == end) break;
+
+        str++;
+        char next = str < end ? *str : '\0';
+        switch(next) {
+            case '"':
+            case '\\':
+            case '/':
+                *p++ = next;
+                break;
+            case 'b':*p++ = 8;break;
+            case 't':*p++ = 9;break;
+            case 'n':*p++ = 10;break;
+            case 'v':*p++ = 11;break;
+            case 'f':*p++ = 12;break;
+            case 'r':*p++ = 13;break;
+            case 'u': {
+                long cp = _season_hex4(str + 1, end);
+                if (cp < 0)
+                    SEASON_PARSE_ERROR("Invalid unicode escape in string");
+                str += 4;
+                if (cp >= 0xDC00 && cp <= 0xDFFF)
+                    SEASON_PARSE_ERROR("Unpaired low surrogate in unicode escape");
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    long low = -1;
+                    if (end - str > 2 && str[1] == '\\' && str[2] == 'u')
+                        low = _season_hex4(str + 3, end);
+                    if (low < 0xDC00 || low > 0xDFFF)
+                        SEASON_PARSE_ERROR("Unpaired high surrogate in unicode escape");
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    str += 6;
+                }
+                p += _season_utf8_encode(p, cp);
+                break;
             }
-            str++;
-        } else {
-            *p++ = *str++;
+            default:
+                SEASON_PARSE_ERROR("Invalid escape code in string");
         }
+        str++;
     }
     *p = '\0';
+    return p - out;
+}
+
+// Unescaped output is never longer than the input, *out_len receives
+// its length (strings may contain \u0000)
+char *_season_unescape(struct _season_token t, size_t *out_len) {
+    char *out = malloc(t.text_len + 1);
+    SEASON_ASSERT(out != NULL, "Buy more RAM lol");
+    size_t n = _season_unescape_into(out, t);
+    if (out_len) *out_len = n;
     return out;
 }
 
+// Offset of the first byte of t, opening quote included
+size_t _season_token_start(struct _season_lexer *l, struct _season_token t) {
+    return t.text - l->content - (t.type == _SEASON_TOK_STRING);
+}
+
 struct season _season_parse_symbol(struct _season_token t) {
-    struct season value;
+    struct season value = {0};
     switch (t.type) {
         case _SEASON_TOK_STRING:
             value.type = SEASON_STRING;
-            value._string.str = _season_unescape(t.text, t.text_len);
-            value._string.len = t.text_len;
+            value._string.str = _season_unescape(t, &value._string.len);
             break;
         case _SEASON_TOK_NUMBER:
             value.type = SEASON_NUMBER;
@@ -484,17 +1072,19 @@ struct season _season_parse_symbol(struct _season_token t) {
 struct season _season_parse_array(struct _season_lexer *l);
 struct season _season_parse_object(struct _season_lexer *l) {
     struct season object = {.type = SEASON_OBJECT};
+    size_t base = l->cursor - 1;
     struct _season_token t = _season_lex_next(l);
     while (t.type != _SEASON_TOK_CLOSE_CURLY) {
         if (t.type != _SEASON_TOK_STRING)
             SEASON_PARSE_ERROR("Expecting key");
-        char *key = _season_unescape(t.text, t.text_len);
+        char *key = _season_unescape(t, NULL);
         t = _season_lex_next(l);
         if (t.type != _SEASON_TOK_COLON)
             SEASON_PARSE_ERROR("Expecting ':'");
         t = _season_lex_next(l);
 
         struct season value;
+        size_t start = _season_token_start(l, t);
         switch (t.type) {
             case _SEASON_TOK_STRING:
             case _SEASON_TOK_NUMBER:
@@ -514,8 +1104,8 @@ struct season _season_parse_object(struct _season_lexer *l) {
             default:
                 SEASON_PARSE_ERROR("Invalid token");
         }
-        season_object_add(&object, key, value);
-        free(key);
+        _SEASON_SPAN(value, start, l->cursor, base);
+        season_object_add_take(&object, key, value);
         t = _season_lex_next(l);
         if (t.type != _SEASON_TOK_CLOSE_CURLY && t.type != _SEASON_TOK_COMMA)
             SEASON_PARSE_ERROR("Expecting ','");
@@ -528,11 +1118,49 @@ struct season _season_parse_object(struct _season_lexer *l) {
     return object;
 }
 
+// Parse a plain integer literal, fails on fractions, exponents and
+// anything that may not fit in 64 bits
+int _season_parse_int(const char *s, size_t len, int64_t *out) {
+    int neg = len && *s == '-';
+    s += neg;
+    len -= neg;
+    if (len == 0 || len > 18) return 0;
+    int64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return 0;
+        v = v*10 + (s[i] - '0');
+    }
+    *out = neg ? -v : v;
+    return 1;
+}
+
+void _season_array_push_token(struct season *array, struct _season_token t) {
+    int64_t i;
+    if (_season_parse_int(t.text, t.text_len, &i)) {
+        if (array->_array.count == 0) array->_packed = _SEASON_PACKED_I64;
+        if (array->_packed == _SEASON_PACKED_I64) {
+            season_array_add_ints(array, &i, 1);
+            return;
+        }
+        double x = (double)i;
+        season_array_add_numbers(array, &x, 1);
+        return;
+    }
+    double x = strtod(t.text, NULL);
+    season_array_add_numbers(array, &x, 1);
+}
+
 struct season _season_parse_array(struct _season_lexer *l) {
     struct season array = {.type = SEASON_ARRAY};
+    size_t base = l->cursor - 1;
     struct _season_token t = _season_lex_next(l);
     while (t.type != _SEASON_TOK_CLOSE_BRACKET) {
+        if (t.type == _SEASON_TOK_NUMBER && (array._packed || array._array.count == 0)) {
+            _season_array_push_token(&array, t);
+            goto next;
+        }
         struct season value;
+        size_t start = _season_token_start(l, t);
         switch (t.type) {
             case _SEASON_TOK_STRING:
             case _SEASON_TOK_NUMBER:
@@ -552,7 +1180,9 @@ struct season _season_parse_array(struct _season_lexer *l) {
             default:
                 SEASON_PARSE_ERROR("Invalid token");
         }
+        _SEASON_SPAN(value, start, l->cursor, base);
         season_array_add(&array, value);
+next:
         t = _season_lex_next(l);
         if (t.type != _SEASON_TOK_CLOSE_BRACKET && t.type != _SEASON_TOK_COMMA)
             SEASON_PARSE_ERROR("Expecting ','");
@@ -565,23 +1195,40 @@ struct season _season_parse_array(struct _season_lexer *l) {
     return array;
 }
 
-int _season_object_idx(struct season *object, const char *key) {
+int _season_object_idx_n(struct season *object, const char *key, size_t len) {
     SEASON_ASSERT(object != NULL, "object must be non-null");
     SEASON_ASSERT(object->type == SEASON_OBJECT, "object must be an object");
 
     for (size_t i = 0; i < object->_object.count; i++) {
-        if (strcmp(object->_object.items[i].key, key) == 0) {
+        const char *k = object->_object.items[i].key;
+        if (strlen(k) == len && memcmp(k, key, len) == 0) {
             return i;
         }
     }
     return -1;
 }
 
+int _season_object_idx(struct season *object, const char *key) {
+    return _season_object_idx_n(object, key, strlen(key));
+}
+
 struct season season_string(const char *s) {
+    return season_string_n(s, strlen(s));
+}
+
+struct season season_string_n(const char *s, size_t len) {
+    char *str = malloc(len + 1);
+    SEASON_ASSERT(str != NULL, "Buy more RAM lol");
+    memcpy(str, s, len);
+    str[len] = '\0';
+    return season_string_take(str, len);
+}
+
+struct season season_string_take(char *s, size_t len) {
     struct season string = {
         .type = SEASON_STRING,
-        ._string.str = _season_strdup(s),
-        ._string.len = strlen(s)
+        ._string.str = s,
+        ._string.len = len
     };
     return string;
 }
@@ -592,49 +1239,129 @@ struct season *season_object_get(struct season *object, const char *key) {
     return object->_object.items[idx].value;
 }
 
-void season_object_add(struct season *object, char *key, struct season item) {
+struct season *season_object_get_n(struct season *object, const char *key, size_t len) {
+    int idx = _season_object_idx_n(object, key, len);
+    if (idx < 0) return NULL;
+    return object->_object.items[idx].value;
+}
+
+void season_object_reserve(struct season *object, size_t capacity) {
+    SEASON_ASSERT(object != NULL, "object must be non-null");
+    SEASON_ASSERT(object->type == SEASON_OBJECT, "object must be an object");
+    _SEASON_ASSERT_OWNED(object);
+    if (capacity <= object->_object.capacity) return;
+    object->_object.capacity = capacity;
+    object->_object.items = realloc(
+        object->_object.items, object->_object.capacity*sizeof(*object->_object.items));
+    SEASON_ASSERT(object->_object.items != NULL, "Buy more RAM lol");
+}
+
+// Add or overwrite key (len bytes), owned_key is used as the key if
+// non-NULL and freed if the key was already present
+void _season_object_put(struct season *object, const char *key, size_t len,
+                        char *owned_key, struct season item) {
     SEASON_ASSERT(object != NULL, "object must be non-null");
     SEASON_ASSERT(object->type == SEASON_OBJECT, "object must be an object");
-    int key_idx = _season_object_idx(object, key);
+    _SEASON_ASSERT_OWNED(object);
+    _SEASON_HASH_FORGET(object);
+    int key_idx = _season_object_idx_n(object, key, len);
     if (key_idx < 0) {
         if (object->_object.count >= object->_object.capacity) {
-            object->_object.capacity =
-                object->_object.capacity == 0 ? 8 : object->_object.capacity*2;
-            object->_object.items = realloc(
-                object->_object.items, object->_object.capacity*sizeof(*object->_object.items));
-            SEASON_ASSERT(object->_object.items != NULL, "Buy more RAM lol");
+            season_object_reserve(object,
+                object->_object.capacity == 0 ? 8 : object->_object.capacity*2);
         }
         struct _season_object_el *el = &object->_object.items[object->_object.count];
-        el->key = _season_strdup(key);
+        if (owned_key) {
+            el->key = owned_key;
+        } else {
+            el->key = malloc(len + 1);
+            SEASON_ASSERT(el->key != NULL, "Buy more RAM lol");
+            memcpy(el->key, key, len);
+            el->key[len] = '\0';
+        }
         el->value = malloc(sizeof(item));
+        SEASON_ASSERT(el->value != NULL, "Buy more RAM lol");
         memcpy(el->value, &item, sizeof(item));
         object->_object.count++;
     } else {
+        free(owned_key);
         season_free(object->_object.items[key_idx].value);
         memcpy(object->_object.items[key_idx].value, &item, sizeof(item));
     }
 }
 
+void season_object_add(struct season *object, char *key, struct season item) {
+    _season_object_put(object, key, strlen(key), NULL, item);
+}
+
+void season_object_add_n(struct season *object, const char *key, size_t len, struct season item) {
+    const char *nul = memchr(key, '\0', len);
+    if (nul) len = nul - key;
+    _season_object_put(object, key, len, NULL, item);
+}
+
+void season_object_add_take(struct season *object, char *key, struct season item) {
+    _season_object_put(object, key, strlen(key), key, item);
+}
+
 void season_object_remove(struct season *object, char *key) {
     SEASON_ASSERT(object != NULL, "object must be non-null");
     SEASON_ASSERT(object->type == SEASON_OBJECT, "object must be an object");
+    _SEASON_ASSERT_OWNED(object);
 
     int idx = _season_object_idx(object, key);
     if (idx >= 0) {
+        _SEASON_HASH_FORGET(object);
         free(object->_object.items[idx].key);
         season_free(object->_object.items[idx].value);
         free(object->_object.items[idx].value);
-        memcpy(&object->_object.items[idx], &object->_object.items[idx+1],
+        memmove(&object->_object.items[idx], &object->_object.items[idx+1],
             (object->_object.count-idx-1)*sizeof(*object->_object.items));
         object->_object.count--;
     }
 }
 
+void _season_array_grow(struct season *array, size_t capacity, size_t item_size) {
+    if (capacity <= array->_array.capacity) return;
+    array->_array.capacity = capacity;
+    array->_array.items = realloc(array->_array.items, capacity*item_size);
+    SEASON_ASSERT(array->_array.items != NULL, "Buy more RAM lol");
+}
+
+size_t _season_array_item_size(struct season *array) {
+    return array->_packed ? sizeof(double) : sizeof(struct season);
+}
+
+// Convert a packed array back to generic storage
+void _season_array_unpack(struct season *array) {
+    if (!array->_packed) return;
+    size_t capacity = array->_array.capacity;
+    struct season *items = malloc((capacity ? capacity : 1)*sizeof(*items));
+    SEASON_ASSERT(items != NULL, "Buy more RAM lol");
+    for (size_t i = 0; i < array->_array.count; i++) {
+        items[i] = season_number(season_array_number(array, i));
+    }
+    free(array->_array.items);
+    array->_array.items = items;
+    array->_packed = _SEASON_PACKED_NONE;
+}
+
+// Convert a packed int64_t array to packed doubles, in place
+void _season_array_widen(struct season *array) {
+    if (array->_packed != _SEASON_PACKED_I64) return;
+    for (size_t i = 0; i < array->_array.count; i++) {
+        int64_t v = array->_array.i64[i];
+        array->_array.f64[i] = (double)v;
+    }
+    array->_packed = _SEASON_PACKED_F64;
+}
+
 struct season *season_array_get(struct season *array, size_t idx) {
     SEASON_ASSERT(array != NULL, "array must be non-null");
     SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
 
     if (idx < array->_object.count) {
+        _season_array_unpack(array);
         return &array->_array.items[idx];
     }
     return NULL;
@@ -649,57 +1376,451 @@ void season_array_add(struct season *array, struct season item) {
 void season_array_remove(struct season *array, size_t idx) {
     SEASON_ASSERT(array != NULL, "array must be non-null");
     SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    _SEASON_ASSERT_OWNED(array);
 
     if (idx >= array->_object.count) return;
 
-    season_free(&array->_array.items[idx]);
-    memcpy(&array->_array.items[idx], &array->_array.items[idx+1],
-        (array->_array.count-idx-1)*sizeof(*array->_array.items));
+    _SEASON_HASH_FORGET(array);
+    size_t size = _season_array_item_size(array);
+    char *items = (char *)array->_array.items;
+    if (!array->_packed) season_free(&array->_array.items[idx]);
+    memmove(items + idx*size, items + (idx+1)*size, (array->_array.count-idx-1)*size);
     array->_array.count--;
 }
 
 void season_array_insert(struct season *array, struct season item, size_t idx) {
     SEASON_ASSERT(array != NULL, "array must be non-null");
     SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    _SEASON_ASSERT_OWNED(array);
 
     if (idx > array->_object.count) idx = array->_object.count;
+    _SEASON_HASH_FORGET(array);
+
+    if (item.type != SEASON_NUMBER) {
+        _season_array_unpack(array);
+    } else if (array->_packed == _SEASON_PACKED_I64
+            && !(item.number > -9e18 && item.number < 9e18
+                 && item.number == (double)(int64_t)item.number)) {
+        _season_array_widen(array);
+    }
 
     if (array->_array.count >= array->_array.capacity) {
-        array->_array.capacity =
-            array->_array.capacity == 0 ? 8 : array->_array.capacity*2;
-        array->_array.items = realloc(
-            array->_array.items, array->_array.capacity*sizeof(*array->_array.items));
-        SEASON_ASSERT(array->_array.items != NULL, "Buy more RAM lol");
-    }
-    memcpy(&array->_array.items[idx+1], &array->_array.items[idx],
-        (array->_array.count-idx)*sizeof(*array->_array.items));
-    array->_array.items[idx] = item;
+        _season_array_grow(array, array->_array.capacity == 0 ? 8 : array->_array.capacity*2,
+                           _season_array_item_size(array));
+    }
+    size_t size = _season_array_item_size(array);
+    char *items = (char *)array->_array.items;
+    memmove(items + (idx+1)*size, items + idx*size, (array->_array.count-idx)*size);
+    switch (array->_packed) {
+        case _SEASON_PACKED_I64:
+            array->_array.i64[idx] = (int64_t)item.number;
+            break;
+        case _SEASON_PACKED_F64:
+            array->_array.f64[idx] = item.number;
+            break;
+        default:
+            array->_array.items[idx] = item;
+            break;
+    }
     array->_array.count++;
 }
 
-void season_load(struct season *season, char *json_string) {
-    struct _season_lexer l = _season_lex_init(json_string, strlen(json_string));
-    struct _season_token t = _season_lex_next(&l);
+void season_array_reserve(struct season *array, size_t capacity) {
+    SEASON_ASSERT(array != NULL, "array must be non-null");
+    SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    _SEASON_ASSERT_OWNED(array);
+    _season_array_grow(array, capacity, _season_array_item_size(array));
+}
+
+double season_array_number(struct season *array, size_t idx) {
+    SEASON_ASSERT(array != NULL, "array must be non-null");
+    SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    SEASON_ASSERT(idx < array->_array.count, "idx must be in range");
+    switch (array->_packed) {
+        case _SEASON_PACKED_I64: return (double)array->_array.i64[idx];
+        case _SEASON_PACKED_F64: return array->_array.f64[idx];
+    }
+    SEASON_ASSERT(array->_array.items[idx].type == SEASON_NUMBER, "item must be a number");
+    return array->_array.items[idx].number;
+}
+
+int64_t season_array_int(struct season *array, size_t idx) {
+    SEASON_ASSERT(array != NULL, "array must be non-null");
+    SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    SEASON_ASSERT(idx < array->_array.count, "idx must be in range");
+    if (array->_packed == _SEASON_PACKED_I64) return array->_array.i64[idx];
+    return (int64_t)season_array_number(array, idx);
+}
+
+double *season_array_doubles(struct season *array) {
+    SEASON_ASSERT(array != NULL, "array must be non-null");
+    SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    return array->_packed == _SEASON_PACKED_F64 ? array->_array.f64 : NULL;
+}
+
+int64_t *season_array_ints(struct season *array) {
+    SEASON_ASSERT(array != NULL, "array must be non-null");
+    SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    return array->_packed == _SEASON_PACKED_I64 ? array->_array.i64 : NULL;
+}
+
+// Make room for n more items, growing geometrically
+void _season_array_reserve_more(struct season *array, size_t n) {
+    size_t needed = array->_array.count + n;
+    if (needed <= array->_array.capacity) return;
+    size_t capacity = array->_array.capacity == 0 ? 8 : array->_array.capacity*2;
+    if (capacity < needed) capacity = needed;
+    _season_array_grow(array, capacity, _season_array_item_size(array));
+}
+
+void season_array_add_numbers(struct season *array, const double *values, size_t n) {
+    SEASON_ASSERT(array != NULL, "array must be non-null");
+    SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    _SEASON_ASSERT_OWNED(array);
+    if (!n) return;
+    _SEASON_HASH_FORGET(array);
+    // A generic buffer is large enough for as many doubles
+    if (array->_array.count == 0) array->_packed = _SEASON_PACKED_F64;
+    _season_array_widen(array);
+    _season_array_reserve_more(array, n);
+    size_t count = array->_array.count;
+    if (array->_packed) {
+        memcpy(array->_array.f64 + count, values, n*sizeof(*values));
+    } else {
+        for (size_t i = 0; i < n; i++)
+            array->_array.items[count + i] = season_number(values[i]);
+    }
+    array->_array.count += n;
+}
+
+void season_array_add_ints(struct season *array, const int64_t *values, size_t n) {
+    SEASON_ASSERT(array != NULL, "array must be non-null");
+    SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    _SEASON_ASSERT_OWNED(array);
+    if (!n) return;
+    _SEASON_HASH_FORGET(array);
+    if (array->_array.count == 0) array->_packed = _SEASON_PACKED_I64;
+    _season_array_reserve_more(array, n);
+    size_t count = array->_array.count;
+    switch (array->_packed) {
+        case _SEASON_PACKED_I64:
+            memcpy(array->_array.i64 + count, values, n*sizeof(*values));
+            break;
+        case _SEASON_PACKED_F64:
+            for (size_t i = 0; i < n; i++)
+                array->_array.f64[count + i] = (double)values[i];
+            break;
+        default:
+            for (size_t i = 0; i < n; i++)
+                array->_array.items[count + i] = season_number((double)values[i]);
+            break;
+    }
+    array->_array.count += n;
+}
+
+enum _season_reduce_op { _SEASON_SUM, _SEASON_MIN, _SEASON_MAX };
+
+double _season_reduce_f64(const double *v, size_t n, enum _season_reduce_op op) {
+    size_t i = 0;
+    double r = op == _SEASON_SUM ? 0 : v[0];
+#if defined(__SSE2__)
+    if (n >= 4) {
+        // Two accumulators of two lanes, combined at the end
+        __m128d a = _mm_loadu_pd(v), b = _mm_loadu_pd(v + 2);
+        if (op == _SEASON_SUM) a = b = _mm_setzero_pd();
+        for (; i + 4 <= n; i += 4) {
+            __m128d x = _mm_loadu_pd(v + i), y = _mm_loadu_pd(v + i + 2);
+            switch (op) {
+                case _SEASON_SUM: a = _mm_add_pd(a, x); b = _mm_add_pd(b, y); break;
+                case _SEASON_MIN: a = _mm_min_pd(a, x); b = _mm_min_pd(b, y); break;
+                case _SEASON_MAX: a = _mm_max_pd(a, x); b = _mm_max_pd(b, y); break;
+            }
+        }
+        double lanes[4];
+        _mm_storeu_pd(lanes, a);
+        _mm_storeu_pd(lanes + 2, b);
+        if (op == _SEASON_SUM) {
+            r = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        } else {
+            r = lanes[0];
+            for (int k = 1; k < 4; k++) {
+                if (op == _SEASON_MIN ? lanes[k] < r : lanes[k] > r) r = lanes[k];
+            }
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        switch (op) {
+            case _SEASON_SUM: r += v[i]; break;
+            case _SEASON_MIN: if (v[i] < r) r = v[i]; break;
+            case _SEASON_MAX: if (v[i] > r) r = v[i]; break;
+        }
+    }
+    return r;
+}
+
+// Values in [-2^52, 2^52) summed by blocks of this size can't overflow
+// int64_t lanes, larger ones are summed as doubles
+#define _SEASON_SUM_BLOCK 1024
+
+double _season_reduce_i64(const int64_t *v, size_t n, enum _season_reduce_op op) {
+    size_t i = 0;
+    if (op == _SEASON_SUM) {
+        double r = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi64x((int64_t)1 << 52);
+        while (n - i >= 4) {
+            size_t end = n - i < _SEASON_SUM_BLOCK
+                ? i + ((n - i) & ~(size_t)3) : i + _SEASON_SUM_BLOCK;
+            __m128i a = zero, b = zero, big = zero;
+            for (size_t j = i; j < end; j += 4) {
+                __m128i x = _mm_loadu_si128((const __m128i *)(v + j));
+                __m128i y = _mm_loadu_si128((const __m128i *)(v + j + 2));
+                a = _mm_add_epi64(a, x);
+                b = _mm_add_epi64(b, y);
+                // Out of range iff (v + 2^52) >> 53 != 0
+                big = _mm_or_si128(big, _mm_srli_epi64(_mm_add_epi64(x, bias), 53));
+                big = _mm_or_si128(big, _mm_srli_epi64(_mm_add_epi64(y, bias), 53));
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(big, zero)) == 0xFFFF) {
+                int64_t lanes[2];
+                _mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(a, b));
+                r += (double)(lanes[0] + lanes[1]);
+            } else {
+                for (size_t j = i; j < end; j++) r += (double)v[j];
+            }
+            i = end;
+        }
+#endif
+        for (; i < n; i++) r += (double)v[i];
+        return r;
+    }
+
+    int64_t r = v[0];
+#if defined(__SSE4_2__)
+    if (n >= 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)v);
+        __m128i b = _mm_loadu_si128((const __m128i *)(v + 2));
+        for (i = 4; i + 4 <= n; i += 4) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(v + i));
+            __m128i y = _mm_loadu_si128((const __m128i *)(v + i + 2));
+            if (op == _SEASON_MIN) {
+                a = _mm_blendv_epi8(a, x, _mm_cmpgt_epi64(a, x));
+                b = _mm_blendv_epi8(b, y, _mm_cmpgt_epi64(b, y));
+            } else {
+                a = _mm_blendv_epi8(a, x, _mm_cmpgt_epi64(x, a));
+                b = _mm_blendv_epi8(b, y, _mm_cmpgt_epi64(y, b));
+            }
+        }
+        int64_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, a);
+        _mm_storeu_si128((__m128i *)(lanes + 2), b);
+        r = lanes[0];
+        for (int k = 1; k < 4; k++) {
+            if (op == _SEASON_MIN ? lanes[k] < r : lanes[k] > r) r = lanes[k];
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (op == _SEASON_MIN ? v[i] < r : v[i] > r) r = v[i];
+    }
+    return (double)r;
+}
+
+double _season_array_reduce(struct season *array, enum _season_reduce_op op) {
+    SEASON_ASSERT(array != NULL, "array must be non-null");
+    SEASON_ASSERT(array->type == SEASON_ARRAY, "array must be an array");
+    size_t n = array->_array.count;
+    if (n == 0) return op == _SEASON_SUM ? 0 : NAN;
+    switch (array->_packed) {
+        case _SEASON_PACKED_I64: return _season_reduce_i64(array->_array.i64, n, op);
+        case _SEASON_PACKED_F64: return _season_reduce_f64(array->_array.f64, n, op);
+    }
+    double r = season_array_number(array, 0);
+    for (size_t i = 1; i < n; i++) {
+        double x = season_array_number(array, i);
+        switch (op) {
+            case _SEASON_SUM: r += x; break;
+            case _SEASON_MIN: if (x < r) r = x; break;
+            case _SEASON_MAX: if (x > r) r = x; break;
+        }
+    }
+    return r;
+}
+
+double season_array_sum(struct season *array) {
+    return _season_array_reduce(array, _SEASON_SUM);
+}
+
+double season_array_min(struct season *array) {
+    return _season_array_reduce(array, _SEASON_MIN);
+}
+
+double season_array_max(struct season *array) {
+    return _season_array_reduce(array, _SEASON_MAX);
+}
+
+// Parse the value starting at token t, its span is relative to base
+struct season _season_parse_value(struct _season_lexer *l, struct _season_token t, size_t base) {
+    struct season value;
+    size_t start = _season_token_start(l, t);
     switch (t.type) {
         case _SEASON_TOK_OPEN_CURLY:
-            *season = _season_parse_object(&l);
+            value = _season_parse_object(l);
             break;
         case _SEASON_TOK_OPEN_BRACKET:
-            *season = _season_parse_array(&l);
+            value = _season_parse_array(l);
             break;
         case _SEASON_TOK_STRING:
         case _SEASON_TOK_NUMBER:
         case _SEASON_TOK_NULL:
         case _SEASON_TOK_TRUE:
         case _SEASON_TOK_FALSE:
-            *season = _season_parse_symbol(t);
+            value = _season_parse_symbol(t);
             break;
         default:
             SEASON_PARSE_ERROR("Invalid token");
     }
+    _SEASON_SPAN(value, start, l->cursor, base);
+    return value;
+}
+
+void season_load(struct season *season, char *json_string) {
+    struct _season_lexer l = _season_lex_init(json_string, strlen(json_string));
+    *season = _season_parse_value(&l, _season_lex_next(&l), 0);
+}
+
+#ifdef SEASON_SPANS
+struct season *_season_child(struct season *season, size_t i) {
+    if (season->type == SEASON_OBJECT) return season->_object.items[i].value;
+    return &season->_array.items[i];
+}
+
+size_t _season_child_count(struct season *season) {
+    if (season->type == SEASON_OBJECT) return season->_object.count;
+    if (season->type == SEASON_ARRAY && !season->_packed) return season->_array.count;
+    return 0;
+}
+
+// Bring season, starting at offset abs and enclosing the edit, up to date.
+// The edit leaves the first byte of season untouched, so parsing from abs
+// fails only if the whole document does. Returns 0 if the edit reaches
+// outside of season, the caller then needs to parse a bigger value again
+int _season_reload(struct season *season, size_t abs, struct _season_lexer *l,
+                   size_t edit_start, size_t old_len, size_t new_len) {
+    size_t count = _season_child_count(season);
+    for (size_t i = 0; i < count; i++) {
+        struct season *child = _season_child(season, i);
+        size_t child_abs = abs + child->_span_start;
+        size_t child_start = child->_span_start;
+        if (child->_span_len == 0 || child_abs >= edit_start
+                || edit_start + old_len > child_abs + child->_span_len) continue;
+        if (!_season_reload(child, child_abs, l, edit_start, old_len, new_len)) break;
+
+        // Spliced in child, shift what follows the edit
+        for (size_t j = 0; j < count; j++) {
+            struct season *sibling = _season_child(season, j);
+            if (sibling != child && sibling->_span_start > child_start) {
+                sibling->_span_start += new_len - old_len;
+            }
+        }
+        season->_span_len += new_len - old_len;
+        _SEASON_HASH_FORGET(season);
+        return 1;
+    }
+
+    l->cursor = abs;
+    struct season value = _season_parse_value(l, _season_lex_next(l), abs);
+    if (value._span_start + value._span_len != season->_span_len + new_len - old_len) {
+        season_free(&value);
+        return 0;
+    }
+    value._span_start += season->_span_start;
+    season_free(season);
+    *season = value;
+    return 1;
+}
+
+void season_reload(struct season *season, char *json, size_t len,
+                   size_t edit_start, size_t old_len, size_t new_len) {
+    struct _season_lexer l = _season_lex_init(json, len);
+    // Counting lines up to the edit would cost a scan of the text before it
+    l.offsets = 1;
+    size_t abs = season->_span_start;
+    if (abs < edit_start && edit_start + old_len <= abs + season->_span_len
+            && _season_reload(season, abs, &l, edit_start, old_len, new_len)) {
+        return;
+    }
+    season_free(season);
+    l = _season_lex_init(json, len);
+    *season = _season_parse_value(&l, _season_lex_next(&l), 0);
+}
+#endif
+
+int _season_key_cmp(const void *a, const void *b) {
+    return strcmp(((const struct _season_object_el *)a)->key,
+                  ((const struct _season_object_el *)b)->key);
+}
+
+size_t _season_format_int(char *buf, int64_t v) {
+    char tmp[24];
+    size_t n = 0, len = 0;
+    uint64_t u = v < 0 ? -(uint64_t)v : (uint64_t)v;
+    do {
+        tmp[n++] = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    if (v < 0) buf[len++] = '-';
+    while (n) buf[len++] = tmp[--n];
+    return len;
+}
+
+// Members of object in rendering order, a malloc'd copy if they had to be sorted
+struct _season_object_el *_season_render_items(struct season *object, int flags) {
+    size_t count = object->_object.count;
+    if (!(flags & SEASON_RENDER_CANONICAL) || count < 2) return object->_object.items;
+    struct _season_object_el *sorted = malloc(count*sizeof(*sorted));
+    SEASON_ASSERT(sorted != NULL, "Buy more RAM lol");
+    memcpy(sorted, object->_object.items, count*sizeof(*sorted));
+    qsort(sorted, count, sizeof(*sorted), _season_key_cmp);
+    return sorted;
+}
+
+// Write x into buf (at least _SEASON_NUMBER_MAX bytes), returns the length
+size_t _season_format_number(char *buf, double x, int flags) {
+    if (!(flags & SEASON_RENDER_CANONICAL)) {
+        if (_season_is_int(x))
+            return _season_format_int(buf, (long)x);
+        return snprintf(buf, _SEASON_NUMBER_MAX, "%lf", x);
+    }
+    if (!isfinite(x)) return sprintf(buf, "null");
+    if (x == 0) return sprintf(buf, "0"); // -0 too
+    if (x > -1e17 && x < 1e17 && x == (double)(long long)x)
+        return _season_format_int(buf, (int64_t)x);
+    // Shortest representation that reads back as x
+    size_t len = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        len = sprintf(buf, "%.*g", precision, x);
+        if (strtod(buf, NULL) == x) break;
+    }
+    return len;
+}
+
+size_t _season_format_packed(char *buf, struct season *array, size_t idx, int flags) {
+    // Canonical numbers are formatted from their double value, whatever the storage
+    if (array->_packed == _SEASON_PACKED_F64)
+        return _season_format_number(buf, array->_array.f64[idx], flags);
+    if (!(flags & SEASON_RENDER_CANONICAL))
+        return _season_format_int(buf, array->_array.i64[idx]);
+    return _season_format_number(buf, (double)array->_array.i64[idx], flags);
 }
 
 void season_render(struct season *season, FILE *stream) {
+    season_render_ex(season, stream, 0);
+}
+
+void season_render_ex(struct season *season, FILE *stream, int flags) {
     SEASON_ASSERT(season != NULL, "season must be non-null");
     switch (season->type) {
         case SEASON_NULL:
@@ -709,39 +1830,785 @@ void season_render(struct season *season, FILE *stream) {
             fprintf(stream, "%s", season->boolean ? "true" : "false");
             break;
         case SEASON_STRING:
-            char *escaped = _season_escape(season->_string.str, season->_string.len);
-            fprintf(stream, "\"%s\"", escaped);
-            free(escaped);
+            _season_render_string(stream, season->_string.str, season->_string.len, flags);
             break;
-        case SEASON_NUMBER:
-            if (_season_is_int(season->number))
-                fprintf(stream, "%ld", (long)season->number);
-            else
-                fprintf(stream, "%lf", season->number);
+        case SEASON_NUMBER: {
+            char num[_SEASON_NUMBER_MAX];
+            fwrite(num, 1, _season_format_number(num, season->number, flags), stream);
             break;
-        case SEASON_OBJECT:
+        }
+        case SEASON_OBJECT: {
+            struct _season_object_el *items = _season_render_items(season, flags);
             fprintf(stream, "{");
             for (size_t i = 0; i < season->_object.count; i++) {
-                if (i) fprintf(stream, ", ");
-                struct _season_object_el object = season->_object.items[i];
-                fprintf(stream, "\"%s\": ", object.key);
-                season_render(object.value, stream);
+                if (i) fputs(flags & SEASON_RENDER_COMPACT ? "," : ", ", stream);
+                struct _season_object_el object = items[i];
+                _season_render_string(stream, object.key, strlen(object.key), flags);
+                fputs(flags & SEASON_RENDER_COMPACT ? ":" : ": ", stream);
+                season_render_ex(object.value, stream, flags);
             }
             fprintf(stream, "}");
+            if (items != season->_object.items) free(items);
             break;
+        }
         case SEASON_ARRAY:
             fprintf(stream, "[");
             for (size_t i = 0; i < season->_array.count; i++) {
-                if (i) fprintf(stream, ", ");
-                season_render(&season->_array.items[i], stream);
+                if (i) fputs(flags & SEASON_RENDER_COMPACT ? "," : ", ", stream);
+                if (season->_packed) {
+                    char num[_SEASON_NUMBER_MAX];
+                    fwrite(num, 1, _season_format_packed(num, season, i, flags), stream);
+                } else {
+                    season_render_ex(&season->_array.items[i], stream, flags);
+                }
             }
             fprintf(stream, "]");
             break;
     }
 }
 
+struct _season_render_frame {
+    struct season *node;
+    struct _season_object_el *items; // object members in rendering order
+    size_t idx;
+    int key_done;
+};
+
+void _season_cursor_put(struct season_render_cursor *cur, const char *s, size_t n) {
+    memcpy(cur->pending + cur->pending_len, s, n);
+    cur->pending_len += n;
+}
+
+void _season_cursor_string(struct season_render_cursor *cur, const char *str, size_t len) {
+    _season_cursor_put(cur, "\"", 1);
+    cur->str = str;
+    cur->str_len = len;
+    cur->in_str = 1;
+}
+
+void _season_cursor_start(struct season_render_cursor *cur, struct season *season) {
+    switch (season->type) {
+        case SEASON_NULL:
+            _season_cursor_put(cur, "null", 4);
+            break;
+        case SEASON_BOOLEAN:
+            if (season->boolean) _season_cursor_put(cur, "true", 4);
+            else _season_cursor_put(cur, "false", 5);
+            break;
+        case SEASON_NUMBER:
+            cur->pending_len += _season_format_number(
+                cur->pending + cur->pending_len, season->number, cur->flags);
+            break;
+        case SEASON_STRING:
+            _season_cursor_string(cur, season->_string.str, season->_string.len);
+            break;
+        case SEASON_OBJECT:
+        case SEASON_ARRAY:
+            _season_cursor_put(cur, season->type == SEASON_OBJECT ? "{" : "[", 1);
+            if (cur->depth >= cur->capacity) {
+                cur->capacity = cur->capacity == 0 ? 8 : cur->capacity*2;
+                cur->stack = realloc(cur->stack, cur->capacity*sizeof(*cur->stack));
+                SEASON_ASSERT(cur->stack != NULL, "Buy more RAM lol");
+            }
+            struct _season_render_frame *f = &cur->stack[cur->depth++];
+            f->node = season;
+            f->items = season->type == SEASON_OBJECT
+                ? _season_render_items(season, cur->flags) : NULL;
+            f->idx = 0;
+            f->key_done = 0;
+            break;
+    }
+}
+
+// Queue the next piece of output, returns 0 once everything was
+int _season_cursor_step(struct season_render_cursor *cur) {
+    if (cur->next) {
+        struct season *next = cur->next;
+        cur->next = NULL;
+        _season_cursor_start(cur, next);
+        return 1;
+    }
+    if (!cur->depth) return 0;
+
+    struct _season_render_frame *f = &cur->stack[cur->depth-1];
+    struct season *node = f->node;
+    const char *sep = cur->flags & SEASON_RENDER_COMPACT ? "," : ", ";
+    if (node->type == SEASON_OBJECT) {
+        if (f->key_done) {
+            const char *colon = cur->flags & SEASON_RENDER_COMPACT ? ":" : ": ";
+            _season_cursor_put(cur, colon, strlen(colon));
+            cur->next = f->items[f->idx++].value;
+            f->key_done = 0;
+            return 1;
+        }
+        if (f->idx == node->_object.count) {
+            _season_cursor_put(cur, "}", 1);
+            if (f->items != node->_object.items) free(f->items);
+            cur->depth--;
+            return 1;
+        }
+        if (f->idx) _season_cursor_put(cur, sep, strlen(sep));
+        const char *key = f->items[f->idx].key;
+        _season_cursor_string(cur, key, strlen(key));
+        f->key_done = 1;
+        return 1;
+    }
+
+    if (f->idx == node->_array.count) {
+        _season_cursor_put(cur, "]", 1);
+        cur->depth--;
+        return 1;
+    }
+    if (f->idx) _season_cursor_put(cur, sep, strlen(sep));
+    if (node->_packed) {
+        cur->pending_len += _season_format_packed(
+            cur->pending + cur->pending_len, node, f->idx, cur->flags);
+    } else {
+        cur->next = &node->_array.items[f->idx];
+    }
+    f->idx++;
+    return 1;
+}
+
+void season_render_begin(struct season_render_cursor *cur, struct season *season, int flags) {
+    SEASON_ASSERT(cur != NULL, "cursor must be non-null");
+    SEASON_ASSERT(season != NULL, "season must be non-null");
+    memset(cur, 0, sizeof(*cur));
+    cur->flags = flags;
+    cur->next = season;
+}
+
+size_t season_render_next(struct season_render_cursor *cur, char *buf, size_t cap) {
+    SEASON_ASSERT(cur != NULL, "cursor must be non-null");
+    SEASON_ASSERT(buf != NULL && cap > 0, "buf must have room");
+    size_t n = 0;
+    while (n < cap) {
+        if (cur->pending_off < cur->pending_len) {
+            size_t k = cur->pending_len - cur->pending_off;
+            if (k > cap - n) k = cap - n;
+            memcpy(buf + n, cur->pending + cur->pending_off, k);
+            cur->pending_off += k;
+            n += k;
+            continue;
+        }
+        cur->pending_len = 0;
+        cur->pending_off = 0;
+
+        if (cur->in_str) {
+            if (!cur->str_len) {
+                cur->in_str = 0;
+                _season_cursor_put(cur, "\"", 1);
+                continue;
+            }
+            size_t limit = cur->str_len < cap - n ? cur->str_len : cap - n;
+            size_t run = _season_escape_scan(cur->str, limit, cur->flags);
+            memcpy(buf + n, cur->str, run);
+            n += run;
+            cur->str += run;
+            cur->str_len -= run;
+            if (run < limit) {
+                size_t k;
+                cur->pending_len = _season_escape_char(cur->pending, cur->str, cur->str_len, &k);
+                cur->str += k;
+                cur->str_len -= k;
+            }
+            continue;
+        }
+
+        if (!_season_cursor_step(cur)) {
+            season_render_end(cur);
+            break;
+        }
+    }
+    return n;
+}
+
+void season_render_end(struct season_render_cursor *cur) {
+    SEASON_ASSERT(cur != NULL, "cursor must be non-null");
+    for (size_t i = 0; i < cur->depth; i++) {
+        struct _season_render_frame f = cur->stack[i];
+        if (f.node->type == SEASON_OBJECT && f.items != f.node->_object.items) free(f.items);
+    }
+    free(cur->stack);
+    cur->stack = NULL;
+    cur->depth = 0;
+    cur->capacity = 0;
+    cur->next = NULL;
+    cur->in_str = 0;
+    cur->pending_len = 0;
+    cur->pending_off = 0;
+}
+
+#define _SEASON_HASH_K1 0x9E3779B97F4A7C15ULL
+#define _SEASON_HASH_K2 0xC2B2AE3D27D4EB4FULL
+
+uint64_t _season_hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t _season_hash_bytes(const char *s, size_t len, uint64_t seed) {
+    uint64_t h = seed ^ (len * _SEASON_HASH_K1);
+    uint64_t k;
+    for (; len >= 8; s += 8, len -= 8) {
+        memcpy(&k, s, 8);
+        h ^= k * _SEASON_HASH_K2;
+        h = ((h << 31) | (h >> 33)) * _SEASON_HASH_K1;
+    }
+    k = 0;
+    memcpy(&k, s, len);
+    h ^= k * _SEASON_HASH_K2;
+    return _season_hash_mix(h);
+}
+
+uint64_t _season_hash_number(double x) {
+    uint64_t bits;
+    if (x == 0) x = 0; // -0 hashes as 0
+    memcpy(&bits, &x, sizeof(bits));
+    return _season_hash_mix(bits ^ (SEASON_NUMBER * _SEASON_HASH_K1));
+}
+
+uint64_t season_hash(struct season *season) {
+    SEASON_ASSERT(season != NULL, "season must be non-null");
+#ifdef SEASON_HASH_MEMO
+    if (season->_hash) return season->_hash;
+#endif
+    uint64_t h = 0;
+    switch (season->type) {
+        case SEASON_NULL:
+            h = _season_hash_mix(SEASON_NULL * _SEASON_HASH_K1);
+            break;
+        case SEASON_BOOLEAN:
+            h = _season_hash_mix((SEASON_BOOLEAN * _SEASON_HASH_K1) ^ (season->boolean != 0));
+            break;
+        case SEASON_NUMBER:
+            h = _season_hash_number(season->number);
+            break;
+        case SEASON_STRING:
+            h = _season_hash_bytes(season->_string.str, season->_string.len,
+                                   SEASON_STRING * _SEASON_HASH_K1);
+            break;
+        case SEASON_OBJECT:
+            // Members are summed so their order doesn't matter
+            for (size_t i = 0; i < season->_object.count; i++) {
+                struct _season_object_el el = season->_object.items[i];
+                uint64_t hk = _season_hash_bytes(el.key, strlen(el.key), 0);
+                h += _season_hash_mix(hk ^ (season_hash(el.value) * _SEASON_HASH_K2));
+            }
+            h = _season_hash_mix(h ^ (SEASON_OBJECT * _SEASON_HASH_K1) ^ season->_object.count);
+            break;
+        case SEASON_ARRAY:
+            h = (SEASON_ARRAY * _SEASON_HASH_K1) ^ season->_array.count;
+            for (size_t i = 0; i < season->_array.count; i++) {
+                uint64_t hi = season->_packed
+                    ? _season_hash_number(season_array_number(season, i))
+                    : season_hash(&season->_array.items[i]);
+                h = _season_hash_mix(h ^ hi);
+            }
+            break;
+    }
+#ifdef SEASON_HASH_MEMO
+    if (!h) h = 1;
+    season->_hash = h;
+#endif
+    return h;
+}
+
+void season_hash_reset(struct season *season) {
+    SEASON_ASSERT(season != NULL, "season must be non-null");
+#ifdef SEASON_HASH_MEMO
+    season->_hash = 0;
+    if (season->type == SEASON_OBJECT) {
+        for (size_t i = 0; i < season->_object.count; i++)
+            season_hash_reset(season->_object.items[i].value);
+    } else if (season->type == SEASON_ARRAY && !season->_packed) {
+        for (size_t i = 0; i < season->_array.count; i++)
+            season_hash_reset(&season->_array.items[i]);
+    }
+#endif
+}
+
+int season_equal(struct season *a, struct season *b) {
+    SEASON_ASSERT(a != NULL && b != NULL, "seasons must be non-null");
+    if (a == b) return 1;
+    if (a->type != b->type) return 0;
+#ifdef SEASON_HASH_MEMO
+    if (season_hash(a) != season_hash(b)) return 0;
+#endif
+    switch (a->type) {
+        case SEASON_NULL:
+            return 1;
+        case SEASON_BOOLEAN:
+            return !a->boolean == !b->boolean;
+        case SEASON_NUMBER:
+            return a->number == b->number;
+        case SEASON_STRING:
+            return a->_string.len == b->_string.len
+                && memcmp(a->_string.str, b->_string.str, a->_string.len) == 0;
+        case SEASON_OBJECT:
+            if (a->_object.count != b->_object.count) return 0;
+            for (size_t i = 0; i < a->_object.count; i++) {
+                struct _season_object_el el = a->_object.items[i];
+                struct season *other;
+                // Members are usually in the same order, avoid the lookup
+                if (strcmp(el.key, b->_object.items[i].key) == 0)
+                    other = b->_object.items[i].value;
+                else if ((other = season_object_get(b, el.key)) == NULL)
+                    return 0;
+                if (!season_equal(el.value, other)) return 0;
+            }
+            return 1;
+        case SEASON_ARRAY:
+            if (a->_array.count != b->_array.count) return 0;
+            for (size_t i = 0; i < a->_array.count; i++) {
+                struct season na, nb;
+                struct season *ia = &na, *ib = &nb;
+                if (a->_packed) na = season_number(season_array_number(a, i));
+                else ia = &a->_array.items[i];
+                if (b->_packed) nb = season_number(season_array_number(b, i));
+                else ib = &b->_array.items[i];
+                if (!season_equal(ia, ib)) return 0;
+            }
+            return 1;
+    }
+    return 0;
+}
+
+#define _SEASON_ARENA_MIN 65536
+#define _SEASON_INTERN_MAX 4096   // keys interned by a parser
+#define _SEASON_INTERN_KEY_MAX 64 // longer keys are not interned
+
+struct _season_arena_block {
+    struct _season_arena_block *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+struct _season_parser_member {
+    char *key;
+    struct season value;
+};
+
+struct _season_interned {
+    uint64_t hash;
+    size_t len;
+    char *key;
+};
+
+void season_parser_init(struct season_parser *parser) {
+    SEASON_ASSERT(parser != NULL, "parser must be non-null");
+    memset(parser, 0, sizeof(*parser));
+}
+
+void *_season_arena_alloc(struct season_parser *p, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    struct _season_arena_block *b = p->arena;
+    if (b == NULL || b->size - b->used < size) {
+        size_t block = p->arena_hint > _SEASON_ARENA_MIN ? p->arena_hint : _SEASON_ARENA_MIN;
+        if (b && b->size*2 > block) block = b->size*2;
+        if (block < size) block = size;
+        b = malloc(sizeof(*b) + block);
+        SEASON_ASSERT(b != NULL, "Buy more RAM lol");
+        b->next = p->arena;
+        b->size = block;
+        b->used = 0;
+        p->arena = b;
+    }
+    void *ptr = b->data + b->used;
+    b->used += size;
+    return ptr;
+}
+
+void _season_parser_intern_insert(struct season_parser *p, struct _season_interned el) {
+    size_t mask = p->interned_capacity - 1;
+    size_t i = el.hash & mask;
+    while (p->interned[i].key) i = (i + 1) & mask;
+    p->interned[i] = el;
+    p->interned_count++;
+}
+
+// Key of an object member, shared with previous documents when possible
+char *_season_parser_key(struct season_parser *p, struct _season_token t) {
+    const char *text = t.text;
+    size_t len = t.text_len;
+    char *unescaped = NULL;
+    if (memchr(text, '\\', len)) {
+        unescaped = _season_arena_alloc(p, len + 1);
+        len = _season_unescape_into(unescaped, t);
+        text = unescaped;
+    }
+    if (len > _SEASON_INTERN_KEY_MAX) goto no_intern;
+
+    uint64_t hash = _season_hash_bytes(text, len, 0);
+    size_t mask = p->interned_capacity - 1;
+    for (size_t i = hash & mask; p->interned_capacity && p->interned[i].key; i = (i + 1) & mask) {
+        struct _season_interned el = p->interned[i];
+        if (el.hash == hash && el.len == len && memcmp(el.key, text, len) == 0)
+            return el.key;
+    }
+    if (p->interned_count >= _SEASON_INTERN_MAX) goto no_intern;
+
+    if ((p->interned_count + 1)*2 > p->interned_capacity) {
+        struct _season_interned *old = p->interned;
+        size_t old_capacity = p->interned_capacity;
+        p->interned_capacity = old_capacity ? old_capacity*2 : 64;
+        p->interned = calloc(p->interned_capacity, sizeof(*p->interned));
+        SEASON_ASSERT(p->interned != NULL, "Buy more RAM lol");
+        p->interned_count = 0;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i].key) _season_parser_intern_insert(p, old[i]);
+        }
+        free(old);
+    }
+    struct _season_interned el = {hash, len, malloc(len + 1)};
+    SEASON_ASSERT(el.key != NULL, "Buy more RAM lol");
+    memcpy(el.key, text, len);
+    el.key[len] = '\0';
+    _season_parser_intern_insert(p, el);
+    return el.key;
+
+no_intern:
+    if (unescaped) return unescaped;
+    char *key = _season_arena_alloc(p, len + 1);
+    memcpy(key, text, len);
+    key[len] = '\0';
+    return key;
+}
+
+void _season_parser_value(struct season_parser *p, struct _season_lexer *l,
+                          struct _season_token t, struct season *out);
+
+void _season_parser_object(struct season_parser *p, struct _season_lexer *l, struct season *out) {
+    size_t base = p->members_count;
+    struct _season_token t = _season_lex_next(l);
+    while (t.type != _SEASON_TOK_CLOSE_CURLY) {
+        if (t.type != _SEASON_TOK_STRING)
+            SEASON_PARSE_ERROR("Expecting key");
+        char *key = _season_parser_key(p, t);
+        t = _season_lex_next(l);
+        if (t.type != _SEASON_TOK_COLON)
+            SEASON_PARSE_ERROR("Expecting ':'");
+        struct season value;
+        _season_parser_value(p, l, _season_lex_next(l), &value);
+
+        // Last duplicated key wins, like season_object_add
+        size_t i = base;
+        while (i < p->members_count && p->members[i].key != key
+               && strcmp(p->members[i].key, key) != 0) i++;
+        if (i == p->members_count) {
+            if (p->members_count >= p->members_capacity) {
+                p->members_capacity = p->members_capacity == 0 ? 64 : p->members_capacity*2;
+                p->members = realloc(p->members, p->members_capacity*sizeof(*p->members));
+                SEASON_ASSERT(p->members != NULL, "Buy more RAM lol");
+            }
+            p->members[i].key = key;
+            p->members_count++;
+        }
+        p->members[i].value = value;
+
+        t = _season_lex_next(l);
+        if (t.type != _SEASON_TOK_CLOSE_CURLY && t.type != _SEASON_TOK_COMMA)
+            SEASON_PARSE_ERROR("Expecting ','");
+        if (t.type == _SEASON_TOK_COMMA) {
+            t = _season_lex_next(l);
+            if (t.type == _SEASON_TOK_CLOSE_CURLY)
+                SEASON_PARSE_ERROR("Illegal trailing comma before end of object");
+        }
+    }
+
+    // Members are known, allocate them at their exact size
+    size_t count = p->members_count - base;
+    *out = (struct season){.type = SEASON_OBJECT, ._arena = 1};
+    out->_object.count = count;
+    out->_object.capacity = count;
+    if (count) {
+        struct season *values = _season_arena_alloc(p, count*sizeof(*values));
+        out->_object.items = _season_arena_alloc(p, count*sizeof(*out->_object.items));
+        for (size_t i = 0; i < count; i++) {
+            values[i] = p->members[base + i].value;
+            out->_object.items[i].key = p->members[base + i].key;
+            out->_object.items[i].value = &values[i];
+        }
+    }
+    p->members_count = base;
+}
+
+void _season_parser_array(struct season_parser *p, struct _season_lexer *l, struct season *out) {
+    size_t base = p->values_count;
+    struct _season_token t = _season_lex_next(l);
+    while (t.type != _SEASON_TOK_CLOSE_BRACKET) {
+        struct season value;
+        _season_parser_value(p, l, t, &value);
+        if (p->values_count >= p->values_capacity) {
+            p->values_capacity = p->values_capacity == 0 ? 64 : p->values_capacity*2;
+            p->values = realloc(p->values, p->values_capacity*sizeof(*p->values));
+            SEASON_ASSERT(p->values != NULL, "Buy more RAM lol");
+        }
+        p->values[p->values_count++] = value;
+
+        t = _season_lex_next(l);
+        if (t.type != _SEASON_TOK_CLOSE_BRACKET && t.type != _SEASON_TOK_COMMA)
+            SEASON_PARSE_ERROR("Expecting ','");
+        if (t.type == _SEASON_TOK_COMMA) {
+            t = _season_lex_next(l);
+            if (t.type == _SEASON_TOK_CLOSE_BRACKET)
+                SEASON_PARSE_ERROR("Illegal trailing comma before end of array");
+        }
+    }
+
+    size_t count = p->values_count - base;
+    *out = (struct season){.type = SEASON_ARRAY, ._arena = 1};
+    out->_array.count = count;
+    out->_array.capacity = count;
+    if (count) {
+        out->_array.items = _season_arena_alloc(p, count*sizeof(*out->_array.items));
+        memcpy(out->_array.items, p->values + base, count*sizeof(*out->_array.items));
+    }
+    p->values_count = base;
+}
+
+void _season_parser_value(struct season_parser *p, struct _season_lexer *l,
+                          struct _season_token t, struct season *out) {
+    *out = (struct season){.type = SEASON_NULL, ._arena = 1};
+    switch (t.type) {
+        case _SEASON_TOK_STRING: {
+            char *str = _season_arena_alloc(p, t.text_len + 1);
+            out->type = SEASON_STRING;
+            out->_string.str = str;
+            out->_string.len = _season_unescape_into(str, t);
+            break;
+        }
+        case _SEASON_TOK_NUMBER: {
+            int64_t i;
+            out->type = SEASON_NUMBER;
+            if (_season_parse_int(t.text, t.text_len, &i)) {
+                out->number = (double)i;
+            } else {
+                // The input may not be terminated, strtod needs it to be
+                char num[64];
+                char *buf = t.text_len < sizeof(num) ? num : _season_arena_alloc(p, t.text_len + 1);
+                memcpy(buf, t.text, t.text_len);
+                buf[t.text_len] = '\0';
+                out->number = strtod(buf, NULL);
+            }
+            break;
+        }
+        case _SEASON_TOK_NULL:
+            break;
+        case _SEASON_TOK_TRUE:
+        case _SEASON_TOK_FALSE:
+            out->type = SEASON_BOOLEAN;
+            out->boolean = t.type == _SEASON_TOK_TRUE;
+            break;
+        case _SEASON_TOK_OPEN_CURLY:
+            _season_parser_object(p, l, out);
+            break;
+        case _SEASON_TOK_OPEN_BRACKET:
+            _season_parser_array(p, l, out);
+            break;
+        default:
+            SEASON_PARSE_ERROR("Invalid token");
+    }
+}
+
+void season_parser_load(struct season_parser *parser, struct season *season,
+                        const char *json, size_t len) {
+    SEASON_ASSERT(parser != NULL, "parser must be non-null");
+    SEASON_ASSERT(season != NULL, "season must be non-null");
+    struct _season_lexer l = _season_lex_init((char *)json, len);
+    _season_parser_value(parser, &l, _season_lex_next(&l), season);
+}
+
+void season_parser_reset(struct season_parser *parser) {
+    SEASON_ASSERT(parser != NULL, "parser must be non-null");
+    size_t used = 0;
+    for (struct _season_arena_block *b = parser->arena; b; b = b->next) used += b->used;
+    if (used > parser->arena_hint) parser->arena_hint = used;
+
+    if (parser->arena && parser->arena->next) {
+        // Next documents get a single block as large as all of these
+        while (parser->arena) {
+            struct _season_arena_block *next = parser->arena->next;
+            free(parser->arena);
+            parser->arena = next;
+        }
+    } else if (parser->arena) {
+        parser->arena->used = 0;
+    }
+    parser->values_count = 0;
+    parser->members_count = 0;
+}
+
+void season_parser_free(struct season_parser *parser) {
+    SEASON_ASSERT(parser != NULL, "parser must be non-null");
+    while (parser->arena) {
+        struct _season_arena_block *next = parser->arena->next;
+        free(parser->arena);
+        parser->arena = next;
+    }
+    for (size_t i = 0; i < parser->interned_capacity; i++) free(parser->interned[i].key);
+    free(parser->interned);
+    free(parser->values);
+    free(parser->members);
+    memset(parser, 0, sizeof(*parser));
+}
+
+#define _SEASON_REFORMAT_BUF 65536
+
+struct _season_reformat {
+    FILE *out;
+    char *buf;
+    size_t len;
+    int indent;
+    size_t depth;
+    size_t values;    // top-level values seen
+    int pending_open; // container opened, nothing written inside yet
+    int in_scalar;    // inside a number or literal
+};
+
+void _season_reformat_write(struct _season_reformat *r, const char *s, size_t n) {
+    if (r->len + n > _SEASON_REFORMAT_BUF) {
+        fwrite(r->buf, 1, r->len, r->out);
+        r->len = 0;
+        if (n > _SEASON_REFORMAT_BUF) {
+            fwrite(s, 1, n, r->out);
+            return;
+        }
+    }
+    memcpy(r->buf + r->len, s, n);
+    r->len += n;
+}
+
+void _season_reformat_newline(struct _season_reformat *r, size_t depth) {
+    static const char spaces[] = "                                ";
+    if (!r->indent) return;
+    _season_reformat_write(r, "\n", 1);
+    size_t n = depth * r->indent;
+    while (n) {
+        size_t k = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+        _season_reformat_write(r, spaces, k);
+        n -= k;
+    }
+}
+
+void _season_reformat_begin_value(struct _season_reformat *r) {
+    if (r->pending_open) {
+        r->pending_open = 0;
+        _season_reformat_newline(r, r->depth);
+    }
+    if (r->depth == 0 && r->values++)
+        _season_reformat_write(r, "\n", 1);
+}
+
+void season_reformat(FILE *in, FILE *out, int indent) {
+    SEASON_ASSERT(in != NULL && out != NULL, "streams must be non-null");
+    SEASON_ASSERT(indent >= 0, "indent must be positive");
+
+    char *chunk = malloc(_SEASON_REFORMAT_BUF);
+    struct _season_reformat r = {
+        .out = out,
+        .buf = malloc(_SEASON_REFORMAT_BUF),
+        .indent = indent,
+    };
+    SEASON_ASSERT(chunk != NULL && r.buf != NULL, "Buy more RAM lol");
+
+    int in_string = 0;
+    size_t skip = 0; // escaped character carried over from the previous chunk
+    size_t n;
+    while ((n = fread(chunk, 1, _SEASON_REFORMAT_BUF, in)) > 0) {
+        struct _season_lexer l = _season_lex_init(chunk, n);
+        l.cursor = skip < n ? skip : n;
+        if (skip) _season_reformat_write(&r, chunk, l.cursor);
+        skip -= l.cursor;
+
+        while (l.cursor < n) {
+            size_t start = l.cursor;
+            if (in_string) {
+                (void)_season_lex_string(&l);
+                if (l.cursor < n) {
+                    l.cursor++;
+                    in_string = 0;
+                } else {
+                    skip = l.cursor - n;
+                    l.cursor = n;
+                }
+                _season_reformat_write(&r, chunk + start, l.cursor - start);
+                continue;
+            }
+
+            char c = chunk[l.cursor++];
+            switch (c) {
+                case ' ':
+                case '\t':
+                case '\n':
+                case '\r':
+                    r.in_scalar = 0;
+                    break;
+                case '"':
+                    r.in_scalar = 0;
+                    _season_reformat_begin_value(&r);
+                    _season_reformat_write(&r, &c, 1);
+                    in_string = 1;
+                    break;
+                case '{':
+                case '[':
+                    r.in_scalar = 0;
+                    _season_reformat_begin_value(&r);
+                    _season_reformat_write(&r, &c, 1);
+                    r.depth++;
+                    r.pending_open = 1;
+                    break;
+                case '}':
+                case ']':
+                    r.in_scalar = 0;
+                    if (r.depth) r.depth--;
+                    if (r.pending_open)
+                        r.pending_open = 0;
+                    else
+                        _season_reformat_newline(&r, r.depth);
+                    _season_reformat_write(&r, &c, 1);
+                    break;
+                case ',':
+                    r.in_scalar = 0;
+                    _season_reformat_write(&r, &c, 1);
+                    _season_reformat_newline(&r, r.depth);
+                    break;
+                case ':':
+                    r.in_scalar = 0;
+                    _season_reformat_write(&r, indent ? ": " : ":", indent ? 2 : 1);
+                    break;
+                default:
+                    if (!r.in_scalar) {
+                        _season_reformat_begin_value(&r);
+                        r.in_scalar = 1;
+                    }
+                    while (l.cursor < n && !isspace((unsigned char)chunk[l.cursor])
+                           && !SEASON_LITERAL_MAP[(unsigned char)chunk[l.cursor]]
+                           && chunk[l.cursor] != '"') {
+                        l.cursor++;
+                    }
+                    _season_reformat_write(&r, chunk + start, l.cursor - start);
+                    break;
+            }
+        }
+    }
+    if (ferror(in))
+        SEASON_ERROR("Failed to read input");
+    if (indent && r.values)
+        _season_reformat_write(&r, "\n", 1);
+    fwrite(r.buf, 1, r.len, out);
+    free(r.buf);
+    free(chunk);
+}
+
 void season_free(struct season *season) {
     SEASON_ASSERT(season != NULL, "season must be non-null");
+    if (season->_arena) return; // freed with its season_parser
     switch (season->type) {
         case SEASON_STRING:
             free(season->_string.str);
@@ -761,10 +2628,11 @@ void season_free(struct season *season) {
             season->_object.capacity = 0;
             break;
         case SEASON_ARRAY:
-            for (size_t i = 0; i < season->_array.count; i++) {
+            for (size_t i = 0; !season->_packed && i < season->_array.count; i++) {
                 season_free(&season->_array.items[i]);
             }
             free(season->_array.items);
+            season->_packed = _SEASON_PACKED_NONE;
             season->_array.items = NULL;
             season->_array.count = 0;
             season->_array.capacity = 0;
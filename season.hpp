@@ -0,0 +1,263 @@
+/* season.hpp
+ * C++17 wrapper over season.h
+ * public domain json reader/writer
+ * https://github.com/Noderyos/SeaSON
+ * no warranty implied; use at your own risk
+
+USAGE
+
+    Include this file anywhere, and do
+        #define SEASON_IMPLEMENTATION
+        #include "season.h"
+    in *one* C file to create the implementation.
+
+DOCUMENTATION
+
+    List of supplied symbols, all in namespace seasonpp
+        * class ref
+            - Non-owning handle on a struct season, cheap to copy.
+            - Only valid as long as the element it points to.
+
+        * class value : public ref
+            - Owning struct season, freed on destruction.
+            - Move-only, moving it into a container does not copy anything.
+
+        * ref::type(), ref::is_null(), ref::is_number(), ...
+            - Element type.
+
+        * ref::as_number(), ref::as_bool(), ref::as_string()
+            - Element content, as_string returns a std::string_view on the element.
+
+        * ref::operator[](std::string_view key), ref::find(std::string_view key)
+            - Object member, find returns a null ref if key is not present.
+            - ref::operator bool() tells if a ref points to something.
+
+        * ref::operator[](size_t idx), ref::size()
+            - Array item / number of object members or array items.
+
+        * class item : public ref
+            - Array item. Items of packed arrays are copies of the number,
+              so reading them doesn't unpack the array. An item can't be
+              turned into a ref, as it could outlive such a copy.
+
+        * ref::set(std::string_view key, value item), ref::push_back(value item)
+            - Add item to an object or an array, item is moved in.
+
+        * ref::reserve(size_t capacity)
+            - Make room for capacity members or items.
+
+        * ref::members(), ref::items()
+            - Range over object members ({key, value}) or array items (item).
+
+        * ref::render(FILE *stream, int flags)
+            - Same as season_render_ex.
+
+        * value::parse(const char *json), value::object(), value::array()
+            - Create value.
+
+        * value::release()
+            - Give up ownership, the caller needs to season_free the result.
+*/
+
+#ifndef SEASON_HPP
+#define SEASON_HPP
+
+#include "season.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace seasonpp {
+
+class value;
+class item;
+
+class ref {
+public:
+    ref() = default;
+    ref(struct season *s) : s_(s) {}
+    ref(const item &) = delete;
+    ref &operator=(const item &) = delete;
+
+    explicit operator bool() const { return s_ != nullptr; }
+    struct season *get() const { return s_; }
+
+    enum season_type type() const { return s_->type; }
+    bool is_null() const { return s_->type == SEASON_NULL; }
+    bool is_number() const { return s_->type == SEASON_NUMBER; }
+    bool is_bool() const { return s_->type == SEASON_BOOLEAN; }
+    bool is_string() const { return s_->type == SEASON_STRING; }
+    bool is_object() const { return s_->type == SEASON_OBJECT; }
+    bool is_array() const { return s_->type == SEASON_ARRAY; }
+
+    double as_number() const { return s_->number; }
+    bool as_bool() const { return s_->boolean != 0; }
+    std::string_view as_string() const {
+        return std::string_view(s_->_string.str, s_->_string.len);
+    }
+
+    ref find(std::string_view key) const {
+        return season_object_get_n(s_, key.data(), key.size());
+    }
+    ref operator[](std::string_view key) const { return find(key); }
+    inline item operator[](size_t idx) const;
+
+    size_t size() const {
+        return s_->type == SEASON_OBJECT ? s_->_object.count : s_->_array.count;
+    }
+
+    inline void set(std::string_view key, value item);
+    inline void push_back(value item);
+
+    void reserve(size_t capacity) {
+        if (s_->type == SEASON_OBJECT) season_object_reserve(s_, capacity);
+        else season_array_reserve(s_, capacity);
+    }
+
+    void render(FILE *stream, int flags = 0) const {
+        season_render_ex(s_, stream, flags);
+    }
+
+    class member_iterator;
+    class item_iterator;
+    template<class It> struct range {
+        It b, e;
+        It begin() const { return b; }
+        It end() const { return e; }
+    };
+
+    inline range<member_iterator> members() const;
+    inline range<item_iterator> items() const;
+
+protected:
+    struct season *s_ = nullptr;
+};
+
+struct member {
+    std::string_view key;
+    ref value;
+};
+
+class ref::member_iterator {
+public:
+    member_iterator(struct season *s, size_t i) : s_(s), i_(i) {}
+    member operator*() const {
+        return {s_->_object.items[i_].key, s_->_object.items[i_].value};
+    }
+    member_iterator &operator++() { i_++; return *this; }
+    bool operator!=(const member_iterator &o) const { return i_ != o.i_; }
+private:
+    struct season *s_;
+    size_t i_;
+};
+
+class item : public ref {
+public:
+    item(struct season *array, size_t idx) {
+        if (array->_packed) {
+            num_.type = SEASON_NUMBER;
+            num_.number = season_array_number(array, idx);
+            s_ = &num_;
+        } else {
+            s_ = season_array_get(array, idx);
+        }
+    }
+    item(const item &o) : ref(o.s_ == &o.num_ ? &num_ : o.s_), num_(o.num_) {}
+    item &operator=(const item &o) {
+        num_ = o.num_;
+        s_ = o.s_ == &o.num_ ? &num_ : o.s_;
+        return *this;
+    }
+
+private:
+    struct season num_ = {};
+};
+
+inline item ref::operator[](size_t idx) const { return item(s_, idx); }
+
+class ref::item_iterator {
+public:
+    item_iterator(struct season *s, size_t i) : s_(s), i_(i) {}
+    item operator*() const { return item(s_, i_); }
+    item_iterator &operator++() { i_++; return *this; }
+    bool operator!=(const item_iterator &o) const { return i_ != o.i_; }
+private:
+    struct season *s_;
+    size_t i_;
+};
+
+inline ref::range<ref::member_iterator> ref::members() const {
+    return {{s_, 0}, {s_, s_->_object.count}};
+}
+
+inline ref::range<ref::item_iterator> ref::items() const {
+    return {{s_, 0}, {s_, s_->_array.count}};
+}
+
+class value : public ref {
+public:
+    value() : value(SEASON_NULL) {}
+    value(std::nullptr_t) : value(SEASON_NULL) {}
+    template<class T, std::enable_if_t<
+        std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    value(T x) : value(SEASON_NUMBER) { v_.number = (double)x; }
+    value(bool x) : value(SEASON_BOOLEAN) { v_.boolean = x; }
+    value(std::string_view str) : ref(&v_) {
+        v_ = season_string_n(str.data(), str.size());
+    }
+    value(const char *str) : value(std::string_view(str)) {}
+    value(const std::string &str) : value(std::string_view(str)) {}
+    // Take ownership of a C element
+    explicit value(struct season s) : ref(&v_), v_(s) {}
+
+    static value object() { return value(SEASON_OBJECT); }
+    static value array() { return value(SEASON_ARRAY); }
+    static value parse(const char *json) {
+        struct season s;
+        season_load(&s, const_cast<char *>(json));
+        return value(s);
+    }
+
+    value(const value &) = delete;
+    value &operator=(const value &) = delete;
+    value(value &&o) noexcept : ref(&v_), v_(o.release()) {}
+    value &operator=(value &&o) noexcept {
+        if (this != &o) {
+            season_free(&v_);
+            v_ = o.release();
+        }
+        return *this;
+    }
+    ~value() { season_free(&v_); }
+
+    struct season release() {
+        struct season s = v_;
+        v_ = season_struct(SEASON_NULL);
+        return s;
+    }
+
+private:
+    explicit value(enum season_type type) : ref(&v_), v_(season_struct(type)) {}
+    static struct season season_struct(enum season_type type) {
+        struct season s = {};
+        s.type = type;
+        return s;
+    }
+
+    struct season v_;
+};
+
+inline void ref::set(std::string_view key, value item) {
+    season_object_add_n(s_, key.data(), key.size(), item.release());
+}
+
+inline void ref::push_back(value item) {
+    season_array_add(s_, item.release());
+}
+
+} // namespace seasonpp
+
+#endif